@@ -3,7 +3,17 @@
  *
  * Copyright (C) 2021 Petar Turukalo
  */
+#define _GNU_SOURCE
 #include "chrp.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Needles longer than this are searched for with memmem(), where the cost of candidates
+ * that match on their first and last bytes only could add up.
+ */
+#define MEMMEM_FILTER_MAX_NEEDLE 32
 
 int chrp_find(char *s, char c, int start, int end)
 {
@@ -154,3 +164,48 @@ void strreplace(char *s, char c, char d)
 			s[i] = d;
 	}
 }
+
+/*
+ * Get whether the needle t of length m > 1 is at the start of s, given its first and last
+ * bytes might not have been compared yet.
+ */
+static bool memmem_cand(char *s, char *t, int m)
+{
+	return s[0] == t[0] && s[m-1] == t[m-1] && memcmp(s+1, t+1, m-2) == 0;
+}
+
+char *chrp_memmem(char *s, int n, char *t, int m)
+{
+	int i = 0;
+
+	if (m == 0)
+		return s;
+	if (m > n)
+		return NULL;
+	if (m == 1)
+		return memchr(s, t[0], n);
+	if (m > MEMMEM_FILTER_MAX_NEEDLE)
+		return memmem(s, n, t, m);
+#ifdef __SSE2__
+	__m128i first = _mm_set1_epi8(t[0]);
+	__m128i last = _mm_set1_epi8(t[m-1]);
+	__m128i eqf, eql;
+	uint mask;
+
+	// Each bit of the mask is a position whose first and last bytes match the needle's.
+	for (; i+m-1+16 <= n; i += 16) {
+		eqf = _mm_cmpeq_epi8(first, _mm_loadu_si128((__m128i *)(s+i)));
+		eql = _mm_cmpeq_epi8(last, _mm_loadu_si128((__m128i *)(s+i+m-1)));
+		for (mask = _mm_movemask_epi8(_mm_and_si128(eqf, eql)); mask; mask &= mask-1) {
+			int j = i+__builtin_ctz(mask);
+			if (memcmp(s+j+1, t+1, m-2) == 0)
+				return s+j;
+		}
+	}
+#endif
+	for (; i+m <= n; ++i) {
+		if (memmem_cand(s+i, t, m))
+			return s+i;
+	}
+	return NULL;
+}
@@ -115,4 +115,17 @@ bool strcmp_suffix(char *s, char *suffix);
  */
 void strreplace(char *s, char c, char d);
 
+/*
+ * chrp_memmem - Find the first occurrence of a needle in a haystack, neither of which
+ *	need be null-terminated
+ * @n: length of the haystack s
+ * @m: length of the needle t
+ *
+ * Candidate positions are filtered by comparing the first and last bytes of the needle
+ * against 16 positions at a time with SSE2 where available, and only the candidates are
+ * compared in full. Long needles are left to memmem(), which is linear time in the worst case.
+ * Return NULL if there is no occurrence.
+ */
+char *chrp_memmem(char *s, int n, char *t, int m);
+
 #endif
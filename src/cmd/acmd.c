@@ -6,6 +6,13 @@
  * Copyright (C) 2021 Petar Turukalo
  */
 #include "cmd.h"
+#include "../display.h"
+#include "../istats.h"
+#include "../log.h"
+#include "../synhl/rule.h"
+
+// Number of the slowest syntax rules shown by the hlstats command.
+#define HLSTATS_NSHOWN 3
 
 /*
  * lsstr - Get a string of a list of the open files in the file buffers
@@ -64,7 +71,99 @@ void acmd_fquit_handler(char *s, bufs_t *b, WINDOW *w)
 	exit(EXIT_SUCCESS);
 }
 
+/*
+ * acmd_display_stats_handler - Handle showing how much drawing the last display of the
+ *	text editor took
+ */
+void acmd_display_stats_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	display_stats_t ds;
+
+	display_get_stats(&ds);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "frame %lu: %d rows drawn, %d curses calls",
+		 ds.frames, ds.rows, ds.calls);
+}
+
+/*
+ * acmd_input_stats_handler - Handle showing the batches keys have been handled in and how
+ *	long they've taken to be drawn
+ */
+void acmd_input_stats_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	input_stats_t is;
+
+	istats_get(&is);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr),
+		 "%lu keys in %lu batches, %d last, %d most; latency %.1fms last, %.1fms most",
+		 is.keys, is.batches, is.last_batch, is.max_batch, is.last_latency_usec/1e3,
+		 is.max_latency_usec/1e3);
+}
+
+/*
+ * Get the index of the syntax rule that has taken the longest to highlight, out of those not
+ * yet shown, -1 if every rule has been shown.
+ * @shown: whether each rule has been shown
+ */
+static int slowest_rule(dlist_t *stats, bool *shown)
+{
+	syntax_rule_stats_t *rs, *slowest = NULL;
+	int r = -1;
+
+	for (int i = 0; i < stats->len; ++i) {
+		rs = dlist_get_address(stats, i);
+		if (!shown[i] && (!slowest || rs->nsec > slowest->nsec)) {
+			slowest = rs;
+			r = i;
+		}
+	}
+	return r;
+}
+
+/*
+ * acmd_hlstats_handler - Handle showing the syntax rules of the active file buffer that
+ *	have taken the longest to highlight, logging the stats of every rule
+ */
+void acmd_hlstats_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	file_syntax_rules_t *frules = find_syntax_rules(fbuf_link_name(b->active_fbuf));
+	strncat_data_t sdata;
+	syntax_rule_stats_t *rs;
+	unsigned long scan_nsec;
+	dlist_t stats;
+	bool *shown;
+	int r;
+
+	if (!frules) {
+		snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "no syntax rules for file");
+		return;
+	}
+	dlist_init(&stats, DLIST_MIN_CAP, sizeof(syntax_rule_stats_t));
+	get_syntax_rules_stats(frules, &stats, &scan_nsec);
+	tlog("syntax rules scanning without a match: %lu ns", scan_nsec);
+	for (int i = 0; i < stats.len; ++i) {
+		rs = dlist_get_address(&stats, i);
+		tlog("syntax rule %s: %lu ns, %lu matches, %lu bytes%s", frules->rules[i].type,
+		     rs->nsec, rs->matches, rs->bytes, rs->disabled ? ", disabled" : "");
+	}
+
+	shown = calloc(stats.len, sizeof(bool));
+	strncat_start(b->cmd_ostr, sizeof(b->cmd_ostr), &sdata);
+	for (int i = 0; i < HLSTATS_NSHOWN && (r = slowest_rule(&stats, shown)) != -1; ++i) {
+		rs = dlist_get_address(&stats, r);
+		strncat_printf_cont(&sdata, "%s%s: %.1fms %lu matches %luB%s", i ? ", " : "",
+				    frules->rules[r].type, rs->nsec/1e6, rs->matches, rs->bytes,
+				    rs->disabled ? " (disabled)" : "");
+		shown[r] = true;
+	}
+	strncat_printf_cont(&sdata, "; no match: %.1fms", scan_nsec/1e6);
+	free(shown);
+	dlist_free(&stats, NULL);
+}
+
 cmd_t acmd_list = { "ls", "list", acmd_list_handler };
 cmd_t acmd_quit = { "q", "quit", acmd_quit_handler };
 cmd_t acmd_fquit = { "fq", "fquit", acmd_fquit_handler };
+cmd_t acmd_display_stats = { "ds", "dstats", acmd_display_stats_handler };
+cmd_t acmd_hlstats = { "hs", "hlstats", acmd_hlstats_handler };
+cmd_t acmd_input_stats = { "is", "istats", acmd_input_stats_handler };
 
@@ -71,7 +71,11 @@ void cmds_init(cmds_t *cs)
 	cmd_t *c;
 	cmd_t *CMDS[] = {
 		&fcmd_write, &fcmd_close, &fcmd_fclose, &fcmd_open, &fcmd_edit, &acmd_list, 
-		&fcmd_jump, &acmd_quit, &acmd_fquit, NULL
+		&fcmd_jump, &acmd_quit, &acmd_fquit, &ecmd_mark, &ecmd_delete, &ecmd_yank,
+		&ecmd_put, &ecmd_join, &ecmd_add_cursor, &ecmd_add_line_cursors, &ecmd_clear_cursors,
+		&scmd_find, &scmd_rfind, &scmd_sub, &scmd_grep, &acmd_display_stats,
+		&acmd_hlstats, &acmd_input_stats,
+		NULL
 	};
 
 	cs->htbl = malloc(sizeof(struct hsearch_data));
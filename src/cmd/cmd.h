@@ -29,6 +29,12 @@ extern cmd_t acmd_list;
 extern cmd_t acmd_quit;
 /* Force quit the program. Discards any unsaved edits. */
 extern cmd_t acmd_fquit;
+/* Show how much drawing the last display of the text editor took. */
+extern cmd_t acmd_display_stats;
+/* Show how long the syntax rules of the active file buffer have taken to highlight. */
+extern cmd_t acmd_hlstats;
+/* Show the batches keys have been handled in and how long they've taken to be drawn. */
+extern cmd_t acmd_input_stats;
 /* Write active file buffer to its linked file or a new file. */
 extern cmd_t fcmd_write;
 /* Close the active file buffer. File buffer must not have any unsaved edits. */
@@ -41,6 +47,30 @@ extern cmd_t fcmd_open;
 extern cmd_t fcmd_edit;
 /* Jump to a file buffer by ID. Helpful to edit unlinked file buffers. */
 extern cmd_t fcmd_jump;
+/* Set the mark at the cursor row, bounding the region of lines range commands apply to. */
+extern cmd_t ecmd_mark;
+/* Delete a range of lines, moving them into the register. */
+extern cmd_t ecmd_delete;
+/* Copy a range of lines into the register. */
+extern cmd_t ecmd_yank;
+/* Insert the lines in the register after the cursor row. */
+extern cmd_t ecmd_put;
+/* Join a range of lines into a single line. */
+extern cmd_t ecmd_join;
+/* Add a cursor at the next match of a string. */
+extern cmd_t ecmd_add_cursor;
+/* Add a cursor on every line in a range. */
+extern cmd_t ecmd_add_line_cursors;
+/* Remove all extra cursors. */
+extern cmd_t ecmd_clear_cursors;
+/* Move the cursor to the next match of a string. */
+extern cmd_t scmd_find;
+/* Move the cursor to the previous match of a string. */
+extern cmd_t scmd_rfind;
+/* Substitute a replacement for the matches of a regex over a range of lines. */
+extern cmd_t scmd_sub;
+/* List the lines matching a regex in every linked file buffer. */
+extern cmd_t scmd_grep;
 
 typedef struct commands {
 	// Hash table of cmd_t for O(1) lookup of a command.
@@ -3,18 +3,43 @@
  *
  * Copyright (C) 2021 Petar Turukalo
  */
+#include <ctype.h>
 #include "cparse.h"
 
+// Size of a buffer large enough to hold any command name.
+#define CMD_NAME_BUFSZ 32
+
 /*
  * Split a string of space separated arguments of format "cmdname [args ...]" into two strings
  * "cmdname" and ["args ..."]. Removes any leading and trailing whitespace.
+ *
+ * Arguments can follow the command name directly when the name is a single punctuation
+ * character, such as "/foo", or when they start with a punctuation character, such as
+ * "sub/a/b/". The name is then copied out into namebuf since there's no room to null-terminate
+ * it in place.
  */
-static void split_args(char *args, char **out_cmdname, char **out_remain_args)
+static void split_args(char *args, char namebuf[CMD_NAME_BUFSZ], char **out_cmdname,
+		       char **out_remain_args)
 {
+	char *end;
+
 	*out_remain_args = NULL;
 
-	if ((*out_cmdname = strnchr(args, ' ')) &&
-	    (*out_remain_args = strchr(*out_cmdname, ' '))) {
+	if (!(*out_cmdname = strnchr(args, ' ')))
+		return;
+	end = *out_cmdname+1;
+	if (isalnum(**out_cmdname)) {
+		while (isalnum(*end))
+			++end;
+	}
+	if (*end && *end != ' ' && (!isalnum(**out_cmdname) || ispunct(*end)) &&
+	    end-*out_cmdname < CMD_NAME_BUFSZ) {
+		memcpy(namebuf, *out_cmdname, end-*out_cmdname);
+		namebuf[end-*out_cmdname] = '\0';
+		*out_cmdname = namebuf;
+		*out_remain_args = end;
+		strip_trailchar(*out_remain_args, ' ');
+	} else if ((*out_remain_args = strchr(*out_cmdname, ' '))) {
 		**out_remain_args = '\0';  // Mark end of command name.
 		if (*out_remain_args = strnchr(*out_remain_args+1, ' '))
 			strip_trailchar(*out_remain_args, ' ');
@@ -24,9 +49,10 @@ static void split_args(char *args, char **out_cmdname, char **out_remain_args)
 void cmds_parse(char *args, cmds_t *cs, bufs_t *b, WINDOW *w)
 {
 	char *cmd_name, *remain_args;
+	char namebuf[CMD_NAME_BUFSZ];
 	cmd_t *c;
 
-	split_args(args, &cmd_name, &remain_args);
+	split_args(args, namebuf, &cmd_name, &remain_args);
 	
 	if (cmd_name) {
 		if (c = cmds_search(cs, cmd_name))
@@ -37,3 +63,47 @@ void cmds_parse(char *args, cmds_t *cs, bufs_t *b, WINDOW *w)
 		strcpy(b->cmd_ostr, "no command name given");
 }
 
+
+/*
+ * Parse a 1-indexed line number into a 0-indexed row, clamped to the rows of lines.
+ * @s: string starting with the line number
+ * @out_end: out-param pointer to the character after the line number
+ *
+ * Return -1 if there is no line number.
+ */
+static int parse_row(char *s, lines_t *ls, char **out_end)
+{
+	long nr = strtol(s, out_end, 10);
+
+	if (*out_end == s || nr < 1)
+		return -1;
+	return lines_add_row(ls, 0, nr-1);
+}
+
+bool cparse_range(char *s, fbuf_t *f, int *out_start, int *out_end)
+{
+	char *end;
+
+	if (!s) {
+		fbuf_region(f, out_start, out_end);
+		return true;
+	}
+	if (strcmp(s, "%") == 0) {
+		*out_start = 0;
+		*out_end = f->lines.len-1;
+		return true;
+	}
+	if ((*out_start = parse_row(s, &f->lines, &end)) == -1)
+		return false;
+	*out_end = *out_start;
+
+	if (*end == ',') {
+		if ((*out_end = parse_row(end+1, &f->lines, &end)) == -1)
+			return false;
+	}
+	if (*end)
+		return false;
+	if (*out_end < *out_start)
+		return false;
+	return true;
+}
@@ -23,4 +23,16 @@
  */
 void cmds_parse(char *args, cmds_t *cs, bufs_t *b, WINDOW *w);
 
+/*
+ * cparse_range - Parse a range of lines in a file buffer that a command applies to
+ * @s: range argument, either "N" for line N, "N,M" for lines N to M, or "%" for every line,
+ *	where line numbers start at 1. NULL for the file buffer's region (see fbuf_region()).
+ * @out_start: out-param 0-indexed first row of the range (inclusive)
+ * @out_end: out-param 0-indexed last row of the range (inclusive)
+ *
+ * Line numbers past the end of the file buffer are clamped to its last line.
+ * Return whether the range argument could be parsed.
+ */
+bool cparse_range(char *s, fbuf_t *f, int *out_start, int *out_end);
+
 #endif
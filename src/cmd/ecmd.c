@@ -0,0 +1,238 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Edit commands. Commands which edit the lines of the active file buffer
+ * over a range of lines (deleting, yanking, putting, etc.).
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <ctype.h>
+#include "cmd.h"
+#include "cparse.h"
+#include "../mcursor.h"
+
+/*
+ * Parse the range argument of a command, setting an error message if it's invalid.
+ * See cparse_range().
+ */
+static bool ecmd_range(char *s, bufs_t *b, int *out_start, int *out_end)
+{
+	if (cparse_range(s, b->active_fbuf, out_start, out_end))
+		return true;
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "invalid range '%s'", s);
+	return false;
+}
+
+/*
+ * ecmd_mark_handler - Handle setting the mark of the active file buffer at its cursor row
+ */
+void ecmd_mark_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	fbuf_t *f = b->active_fbuf;
+
+	fbuf_set_mark(f);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "mark set at line %d", f->mark_row+1);
+}
+
+/*
+ * ecmd_delete_handler - Handle deleting a range of lines from the active file buffer,
+ *	moving them into the register
+ */
+void ecmd_delete_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	int start, end, len;
+	fbuf_t *f = b->active_fbuf;
+
+	if (!ecmd_range(s, b, &start, &end))
+		return;
+	dlist_clear(&b->reg, (dlist_elem_fn)line_free);
+	len = f->lines.len;
+	lines_cut(&f->lines, start, end, &b->reg);
+	// Cutting every line leaves an empty one behind.
+	fbuf_edit(f, start, end-start+1, f->lines.len-len+end-start+1);
+	fbuf_clear_mark(f);
+	fbuf_clear_cursors(f);
+	cursor_set_row(&f->cursor, lines_add_row(&f->lines, start, 0), &f->lines);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "deleted %d lines", b->reg.len);
+}
+
+/*
+ * ecmd_yank_handler - Handle copying a range of lines from the active file buffer into
+ *	the register
+ */
+void ecmd_yank_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	int start, end;
+	fbuf_t *f = b->active_fbuf;
+
+	if (!ecmd_range(s, b, &start, &end))
+		return;
+	dlist_clear(&b->reg, (dlist_elem_fn)line_free);
+	lines_copy_range(&f->lines, start, end, &b->reg);
+	fbuf_clear_mark(f);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "yanked %d lines", b->reg.len);
+}
+
+/*
+ * ecmd_put_handler - Handle inserting the lines in the register after the cursor row
+ *	of the active file buffer
+ */
+void ecmd_put_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	fbuf_t *f = b->active_fbuf;
+
+	if (!b->reg.len) {
+		strcpy(b->cmd_ostr, "register empty");
+		return;
+	}
+	lines_put(&f->lines, f->cursor.row, &b->reg);
+	// The cursor row can gain a newline.
+	fbuf_edit(f, f->cursor.row, 1, 1+b->reg.len);
+	fbuf_clear_cursors(f);
+	// Move onto the first put line.
+	f->cursor.row += 1;
+	cursor_set_col_manual(&f->cursor, 0);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "put %d lines", b->reg.len);
+}
+
+/*
+ * ecmd_join_handler - Handle joining a range of lines in the active file buffer into a
+ *	single line. A range of one line joins it with the line after it.
+ */
+void ecmd_join_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	int start, end, join_col;
+	fbuf_t *f = b->active_fbuf;
+
+	if (!ecmd_range(s, b, &start, &end))
+		return;
+	if (start == end)
+		end = lines_add_row(&f->lines, end, 1);
+	if (start == end) {
+		strcpy(b->cmd_ostr, "no lines to join");
+		return;
+	}
+	join_col = line_len(dlist_get_address(&f->lines, start));
+	lines_join(&f->lines, start, end, f->tabsz);
+	fbuf_edit(f, start, end-start+1, 1);
+	fbuf_clear_mark(f);
+	fbuf_clear_cursors(f);
+	// Put the cursor where the first two lines were joined.
+	f->cursor.row = start;
+	cursor_set_col_manual(&f->cursor, join_col);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "joined %d lines", end-start+1);
+}
+
+static bool isword(char c)
+{
+	return isalnum(c) || c == '_';
+}
+
+/*
+ * Get the word under a cursor.
+ * @out_n: out-param length of the word, 0 if the cursor isn't over a word
+ *
+ * Return the start of the word.
+ */
+static char *word_under_cursor(line_t *l, cursor_t *c, int *out_n)
+{
+	int start = c->col;
+	int end = c->col;
+
+	while (start > 0 && isword(l->array[start-1]))
+		--start;
+	while (end < line_len(l) && isword(l->array[end]))
+		++end;
+	*out_n = end-start;
+	return l->array+start;
+}
+
+/*
+ * ecmd_add_cursor_handler - Handle adding a cursor at the next match of a string after the
+ *	last cursor in the active file buffer, the word under the cursor if no string is given
+ *
+ * The new cursor becomes the primary cursor so that the view follows it.
+ */
+void ecmd_add_cursor_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	fbuf_t *f = b->active_fbuf;
+	cursor_t *extra, *last = &f->cursor;
+	search_t srch;
+	int n, row, col;
+
+	if (s)
+		n = strlen(s);
+	else
+		s = word_under_cursor(fbuf_cur_line(f), &f->cursor, &n);
+	if (!n) {
+		strcpy(b->cmd_ostr, "no string to match");
+		return;
+	}
+	// Extra cursors are sorted, so the last is the furthest along of them.
+	if (f->cursors.len) {
+		extra = dlist_get_address(&f->cursors, f->cursors.len-1);
+		if (extra->row > last->row || (extra->row == last->row && extra->col > last->col))
+			last = extra;
+	}
+	row = last->row;
+	col = last->col;
+	search_init(&srch);
+	search_set(&srch, s, n);
+
+	// Skip over matches already with a cursor, at most until wrapping back around.
+	for (int i = 0; i < f->cursors.len+1; ++i) {
+		if (!search_next(&srch, &f->lines, fbuf_sindex(f), row, col, &row, &col))
+			break;
+		if (!mcursor_exists(&f->cursor, &f->cursors, row, col)) {
+			// The new cursor takes over as the primary cursor.
+			dlist_append(&f->cursors, &f->cursor);
+			f->cursor.row = row;
+			cursor_set_col_manual(&f->cursor, col);
+			mcursor_normalise(&f->cursor, &f->cursors);
+			snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "%d cursors", f->cursors.len+1);
+			search_free(&srch);
+			return;
+		}
+	}
+	search_free(&srch);
+	strcpy(b->cmd_ostr, "no more matches");
+}
+
+/*
+ * ecmd_add_line_cursors_handler - Handle adding a cursor on every line in a range of the
+ *	active file buffer, at the column of the primary cursor
+ */
+void ecmd_add_line_cursors_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	fbuf_t *f = b->active_fbuf;
+	cursor_t c = f->cursor;
+	int start, end;
+
+	if (!ecmd_range(s, b, &start, &end))
+		return;
+	for (int row = start; row <= end; ++row) {
+		cursor_set_row(&c, row, &f->lines);
+		dlist_append(&f->cursors, &c);
+	}
+	// Sort and remove duplicates once rather than per added cursor.
+	mcursor_normalise(&f->cursor, &f->cursors);
+	fbuf_clear_mark(f);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "%d cursors", f->cursors.len+1);
+}
+
+/*
+ * ecmd_clear_cursors_handler - Handle removing all extra cursors from the active file buffer
+ */
+void ecmd_clear_cursors_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	fbuf_clear_cursors(b->active_fbuf);
+}
+
+cmd_t ecmd_mark = { "m", "mark", ecmd_mark_handler };
+cmd_t ecmd_delete = { "d", "delete", ecmd_delete_handler };
+cmd_t ecmd_yank = { "y", "yank", ecmd_yank_handler };
+cmd_t ecmd_put = { "p", "put", ecmd_put_handler };
+cmd_t ecmd_join = { "jn", "join", ecmd_join_handler };
+cmd_t ecmd_add_cursor = { "ac", "addcursor", ecmd_add_cursor_handler };
+cmd_t ecmd_add_line_cursors = { "al", "addlines", ecmd_add_line_cursors_handler };
+cmd_t ecmd_clear_cursors = { "cc", "clearcursors", ecmd_clear_cursors_handler };
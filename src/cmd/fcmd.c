@@ -6,6 +6,7 @@
  *
  * Copyright (C) 2021 Petar Turukalo
  */
+#include <ctype.h>
 #include "cmd.h"
 
 /*
@@ -109,15 +110,59 @@ void fcmd_open_handler(char *fpath, bufs_t *b, WINDOW *w)
 }
 
 /*
- * fcmd_edit_handler - Handle editing of an existing file already opened in a file buffer
+ * Edit an already opened file at a location "path:line", as in the results of the grep command,
+ * moving the cursor to the start of the line. Anything after a colon following the line number
+ * is ignored.
+ *
+ * Return 0 on success, -1 if s isn't a location in an open file.
+ */
+static int edit_location(bufs_t *b, char *s)
+{
+	char *colon, *end;
+	fbuf_t *f;
+	long nr;
+	int ret;
+
+	// Paths can contain colons, so the line number is after the first colon followed by one.
+	for (colon = strchr(s, ':'); colon; colon = strchr(colon+1, ':')) {
+		nr = strtol(colon+1, &end, 10);
+		if (isdigit(colon[1]) && nr > 0 && (*end == ':' || *end == '\0'))
+			break;
+	}
+	if (!colon)
+		return -1;
+	*colon = '\0';
+	ret = bufs_edit(b, s);
+	*colon = ':';
+	if (ret == -1)
+		return -1;
+
+	f = b->active_fbuf;
+	f->cursor.row = lines_add_row(&f->lines, 0, nr-1);
+	cursor_set_col_manual(&f->cursor, 0);
+	return 0;
+}
+
+/*
+ * fcmd_edit_handler - Handle editing of an existing file already opened in a file buffer,
+ *	optionally at a line given as "path:line"
+ *
+ * No filepath given edits the location on the cursor's line, such as a grep result.
  */
 void fcmd_edit_handler(char *fpath, bufs_t *b, WINDOW *w)
 {
+	str_t s;
+
 	if (fpath) {
-		if (bufs_edit(b, fpath) == -1)
+		if (bufs_edit(b, fpath) == -1 && edit_location(b, fpath) == -1)
 			snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "file '%s' not open", fpath);
-	} else
-		strcpy(b->cmd_ostr, "no filepath");
+	} else {
+		str_alloc(&s, 128);
+		line_contract(fbuf_cur_line(b->active_fbuf), &s);
+		if (edit_location(b, s.array) == -1)
+			strcpy(b->cmd_ostr, "no filepath");
+		line_free(&s);
+	}
 }
 
 /*
@@ -0,0 +1,130 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Search commands. Commands which search the lines of the active file buffer.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "cmd.h"
+#include "cparse.h"
+#include "../subst.h"
+#include "../grep.h"
+#include "../redraw.h"
+
+/*
+ * Search the active file buffer for a string, or repeat the last search if no string is given.
+ */
+static void find(char *s, bufs_t *b, bool reverse)
+{
+	if (s)
+		search_set(&b->search, s, strlen(s));
+	if (!b->search.len) {
+		strcpy(b->cmd_ostr, "no search string");
+		return;
+	}
+	// No echo on a match so that the file buffer is swapped back to.
+	if (!bufs_find(b, reverse))
+		strcpy(b->cmd_ostr, "not found");
+}
+
+/*
+ * scmd_find_handler - Handle moving the cursor to the next match of a string in the active
+ *	file buffer
+ */
+void scmd_find_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	find(s, b, false);
+}
+
+/*
+ * scmd_rfind_handler - Handle moving the cursor to the previous match of a string in the
+ *	active file buffer
+ */
+void scmd_rfind_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	find(s, b, true);
+}
+
+/*
+ * scmd_sub_handler - Handle substituting a replacement for the matches of a regex over a range
+ *	of lines in the active file buffer
+ * @s: substitution of format "/pattern/replacement/[g] [range]", see subst_parse() and
+ *	cparse_range()
+ */
+void scmd_sub_handler(char *s, bufs_t *b, WINDOW *w)
+{
+	fbuf_t *f = b->active_fbuf;
+	char *range, errbuf[128];
+	int start, end, nsubs;
+	subst_t sub;
+
+	if (!s || !subst_parse(s, &sub, &range)) {
+		strcpy(b->cmd_ostr, "usage: sub/pattern/replacement/[g] [range]");
+		return;
+	}
+	if (!cparse_range(range, f, &start, &end)) {
+		snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "invalid range '%s'", range);
+		return;
+	}
+	if ((nsubs = subst_lines(&sub, &f->lines, start, end, f->tabsz, errbuf, sizeof(errbuf))) < 0) {
+		snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "invalid pattern: %s", errbuf);
+		return;
+	}
+	if (nsubs) {
+		fbuf_edit(f, start, end-start+1, end-start+1);
+		fbuf_clear_cursors(f);
+		// Substituted lines can be shorter than the cursor column.
+		cursor_set_row(&f->cursor, f->cursor.row, &f->lines);
+	}
+	fbuf_clear_mark(f);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "%d substitutions", nsubs);
+}
+
+/*
+ * scmd_grep_handler - Handle searching every linked file buffer for the lines matching a regex,
+ *	listing them in a new unlinked file buffer
+ *
+ * Results are added as the file buffer of each finishes being searched. The lock of the text
+ * editor data is released while waiting so that they're displayed as they come in. Nothing
+ * can be edited meanwhile since it's the input thread that waits.
+ */
+void scmd_grep_handler(char *pat, bufs_t *b, WINDOW *w)
+{
+	fbuf_t *f;
+	char errbuf[128];
+	int n, nresults = 0;
+	grep_t g;
+
+	if (!pat) {
+		strcpy(b->cmd_ostr, "no pattern");
+		return;
+	}
+	if (!grep_start(&g, pat, &b->fbufs, b->active_fbuf->tabsz, errbuf, sizeof(errbuf))) {
+		snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "invalid pattern: %s", errbuf);
+		return;
+	}
+	// Jobs have their own copy of the lines structs so opening a buffer doesn't disturb them.
+	bufs_new(b, w, b->active_fbuf->tabsz);
+	f = b->active_fbuf;
+
+	while (!grep_finished(&g)) {
+		// Show the results taken so far while waiting for more.
+		redraw_request();
+		if (b->lock)
+			sem_post(b->lock);
+		grep_wait(&g);
+		if (b->lock)
+			sem_wait(b->lock);
+		n = grep_take(&g, &f->lines);
+		// Results are listed rather than edits, so the file buffer has no unsaved edits.
+		fbuf_lines_changed(f, f->lines.len-1-n, 0, n);
+		nresults += n;
+	}
+	grep_free(&g);
+	snprintf(b->cmd_ostr, sizeof(b->cmd_ostr), "%d matching lines", nresults);
+}
+
+cmd_t scmd_find = { "/", "find", scmd_find_handler };
+cmd_t scmd_rfind = { "?", "rfind", scmd_rfind_handler };
+cmd_t scmd_sub = { "s", "sub", scmd_sub_handler };
+cmd_t scmd_grep = { "g", "grep", scmd_grep_handler };
@@ -3,6 +3,7 @@
  *
  * Copyright (C) 2021 Petar Turukalo
  */
+#include <pthread.h>
 #include <unistd.h>
 #include "display.h"
 #include "log.h"
@@ -12,6 +13,31 @@
 static const int ASCII_PRINT_START_INCL = 32;
 static const int ASCII_PRINT_END_INCL = 127;
 
+/*
+ * What was last drawn on a row of the display window from a file buffer, to tell whether
+ * the row needs drawing again.
+ */
+typedef struct drawn_row {
+	bool drawn;  // Whether the row was drawn, otherwise the fields below are unknown.
+	unsigned long version;  // Version of the line drawn (see fbuf struct), 0 for no line.
+	int first_col;  // First column of the line drawn.
+	bool extra_cursors;  // Whether extra cursors were drawn on the row.
+} drawn_row_t;
+
+// Rows (drawn_row_t) of the display window as last drawn, and the spans (dlist_t of
+// regmatch_data_t, see clrmap_t) they were coloured with. Forgotten whenever the window is
+// resized.
+static dlist_t drawn_rows;
+static dlist_t drawn_spans;
+// Cells (chtype) of a row of the display window, reused to display each row.
+static dlist_t row_cells;
+
+// Counts of the frame being drawn, only used by the display, and of the last frame drawn,
+// which are read by other threads under the lock below.
+static display_stats_t stats;
+static display_stats_t last_stats;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * ascii_printable - Get whether a character is an ASCII printable character
  */
@@ -21,110 +47,219 @@ static bool ascii_printable(char c)
 }
 
 /*
- * addnstrtab - Similar to curses addnstr but displays tab characters as specified in
- *	tab.h as spaces
- * @s: string to display
- * @start: index of first character in string to display (inclusive)
- * @end: index of last character in string to display (inclusive)
+ * Get the cell displayed for a character of a line. Tabs are displayed as spaces (see tab.h)
+ * and non-printable characters as '@'.
  */
-void addtabsubstr(char *s, int start, int end, WINDOW *w)
+static chtype display_char(char c)
 {
-	int i = start;
-
-	for (; i <= end; ++i) {
-		if (s[i] == TAB_START || s[i] == TAB_CONT)
-			waddch(w, ' ');
-		else if (s[i] == '\n' || ascii_printable(s[i]))
-			waddch(w, s[i]);
-		else
-			waddch(w, '@');  // Non-printable characters.
-	}
+	if (c == TAB_START || c == TAB_CONT)
+		return ' ';
+	if (ascii_printable(c))
+		return c;
+	return '@';
 }
 
 /*
- * display_fbuf_lines - Display the view of a file buffer's lines
+ * Colour cells of a row with the spans of the line on it, clipped to the cells.
+ * @first_col: column of the line in the first cell
  */
-void display_fbuf_lines(fbuf_t *f, WINDOW *w)
+static void colour_cells(chtype *cells, int ncells, int first_col, dlist_t *spans)
 {
-	int top_row, bot_row, first_col, end_col;
-	int i, view_disp_top_row, view_disp_first_col;
-	line_t *l;
-	view_t *v = &f->view;
-
-	top_row = v->lines_top_row;
-	first_col = v->lines_first_col;
-	bot_row = view_lines_bot_row(v, &f->lines);
-
-	view_disp_top_row = view_display_top_row(v);
-	view_disp_first_col = view_display_first_col(v);
-
-	// Move cursor to display anchor point (top left corner of its displayed view), the
-	// point to start displaying at.
-	wmove(w, view_disp_top_row, view_disp_first_col);
-
-	i = 0;
-	for (int lnr = top_row; lnr <= bot_row; ++lnr, ++i)  {
-		l = dlist_get_address(&f->lines, lnr);
-		end_col = view_line_last_col(v, l);
-		wmove(w, view_disp_top_row+i, view_disp_first_col);  // Move to start of line.
-		addtabsubstr(l->array, first_col, end_col, w);  // Display whole line.
+	regmatch_data_t *span;
+	int i = 0, end;
+
+	for (int k = 0; k < spans->len && i < ncells; ++k) {
+		span = dlist_get_address(spans, k);
+		end = span->end-first_col < ncells ? span->end-first_col : ncells;
+		for (; i < span->start-first_col && i < ncells; ++i)
+			cells[i] |= COLOR_PAIR(COLOUR_DEFAULT);
+		for (; i < end; ++i)
+			cells[i] |= COLOR_PAIR(span->clrpair);
 	}
+	for (; i < ncells; ++i)
+		cells[i] |= COLOR_PAIR(COLOUR_DEFAULT);
 }
 
 /*
- * display_fbuf_cursor - Display the file buffer cursor in view on the curses standard screen
+ * Display a row of a pane of a snapshot with a single curses call. The characters of the
+ * line are merged with their colours and any extra cursors into a row of cells, padded with
+ * spaces to the edge of the window.
+ * @y: row of the screen to display it on
+ * @coloured: whether to colour the row with its spans, otherwise it's displayed without colour
  */
-void display_fbuf_cursor(fbuf_t *f, WINDOW *w)
+static void display_row(snapshot_pane_t *p, snapshot_row_t *r, int y, bool coloured,
+			WINDOW *w)
 {
-	view_t *v;
-	cursor_t *c;
+	int ncells = getmaxx(w)-p->x;
+	chtype *cells = (chtype *)row_cells.array;
+	char *chars = (char *)r->chars.array;
+	int *cursor_cols = (int *)r->cursor_cols.array;
+	int n = 0;
+
+	// The window may have shrunk since the snapshot was taken.
+	if (ncells <= 0)
+		return;
+	for (; n < r->chars.len && n < ncells; ++n)
+		cells[n] = display_char(chars[n]);
+	while (n < ncells)
+		cells[n++] = ' ';
 
-	v = &f->view;
-	c = &f->cursor;
+	if (coloured)
+		colour_cells(cells, ncells, p->first_col, &r->spans);
+	// Extra cursors are displayed in reverse video, keeping the colour of their cell.
+	for (int i = 0; i < r->cursor_cols.len; ++i) {
+		if (cursor_cols[i] < ncells)
+			cells[cursor_cols[i]] |= A_REVERSE;
+	}
 
-	wmove(w, view_cursor_display_row(v, c), view_cursor_display_col(v, c));
+	mvwaddchnstr(w, y, p->x, cells, ncells);
+	++stats.calls;
+	++stats.rows;
+}
+
+static void spans_init(dlist_t *spans)
+{
+	dlist_init(spans, DLIST_MIN_CAP, sizeof(regmatch_data_t));
+}
+
+static void spans_free(dlist_t *spans)
+{
+	dlist_free(spans, NULL);
 }
 
 /*
- * Set the colours in a window to the colours in a colour map.
+ * Forget what was drawn on the display window if it has been resized, so that every row is
+ * drawn again.
  */
-static void display_clrmap(clrmap_t *c, WINDOW *w)
+static void drawn_sync_size(WINDOW *w)
 {
-	int nrows = c->clrmap.nrows;
-	int ncols = c->clrmap.ncols;
-	clrpair_t *clrpair;
+	int nrows = getmaxy(w);
+	drawn_row_t *r;
 
+	if (!drawn_rows.array) {
+		dlist_init(&drawn_rows, nrows, sizeof(drawn_row_t));
+		dlist_init(&drawn_spans, nrows, sizeof(dlist_t));
+		dlist_init(&row_cells, getmaxx(w), sizeof(chtype));
+	}
+	if (drawn_rows.len == nrows && row_cells.len == getmaxx(w))
+		return;
+	dlist_resize_len(&drawn_rows, nrows);
 	for (int i = 0; i < nrows; ++i) {
-		for (int j = 0; j < ncols; ++j) {
-			clrpair = matrix_get_address(&c->clrmap, i, j);
-			mvwchgat(w, i, j, 1, 0, *clrpair, NULL);
-		}
+		r = dlist_get_address(&drawn_rows, i);
+		r->drawn = false;
 	}
+	if (drawn_spans.len > nrows)
+		dlist_delete_range(&drawn_spans, nrows, drawn_spans.len-nrows, (dlist_elem_fn)spans_free);
+	while (drawn_spans.len < nrows)
+		dlist_append_init(&drawn_spans, (dlist_elem_fn)spans_init);
+	dlist_resize_len(&row_cells, getmaxx(w));
 }
 
 /*
- * Display syntax highlighting for a file buffer to the curses standard screen.
- * Assumes the file buffer has already been displayed to the screen.
+ * Get whether a row of the window needs drawing again, as what was drawn on it differs from
+ * what would be drawn now, or its colours differ.
+ * @spans: spans the row would be coloured with now, NULL without colours
  */
-static void display_syntax_highlighting(clrmap_t *c, fbuf_t *f, WINDOW *w)
+static bool row_damaged(drawn_row_t *then, drawn_row_t *now, dlist_t *spans, int y)
 {
-	if (has_colors()) {
-		if (clrmap_syntax_highlight(c, f))
-			display_clrmap(c, w);
+	dlist_t *drawn = dlist_get_address(&drawn_spans, y);
+
+	if (!then->drawn || then->version != now->version || then->first_col != now->first_col ||
+	    then->extra_cursors || now->extra_cursors)
+		return true;
+	return spans && (spans->len != drawn->len ||
+			 memcmp(spans->array, drawn->array, spans->len*sizeof(regmatch_data_t)));
+}
+
+/*
+ * Display the file buffer pane of a snapshot, only drawing the rows that changed since the
+ * last display.
+ */
+static void display_fbuf_damaged_rows(snapshot_t *s, WINDOW *w)
+{
+	snapshot_pane_t *p = &s->fbuf;
+	drawn_row_t now, *then;
+	snapshot_row_t *r;
+	dlist_t *spans;
+	int y;
+
+	drawn_sync_size(w);
+	for (int i = 0; i < p->rows.len; ++i) {
+		r = dlist_get_address(&p->rows, i);
+		y = p->top_y+i;
+		if (y < 0 || y >= drawn_rows.len)
+			continue;
+		now.drawn = true;
+		now.version = r->version;
+		now.first_col = p->first_col;
+		now.extra_cursors = r->cursor_cols.len > 0;
+		then = dlist_get_address(&drawn_rows, y);
+		spans = s->coloured ? &r->spans : NULL;
+		if (!row_damaged(then, &now, spans, y))
+			continue;
+
+		display_row(p, r, y, s->coloured, w);
+		if (spans)
+			dlist_copy(dlist_get_address(&drawn_spans, y), spans, NULL);
+		*then = now;
 	}
 }
 
+/*
+ * Display the echo line pane of a snapshot, which is drawn whole every time as it's only a
+ * line.
+ */
+static void display_elbuf(snapshot_t *s, WINDOW *w)
+{
+	snapshot_pane_t *p = &s->elbuf;
+
+	for (int i = 0; i < p->rows.len; ++i)
+		display_row(p, dlist_get_address(&p->rows, i), p->top_y+i, false, w);
+}
+
+void display_publish(tedata_t *t)
+{
+	snapshots_publish(&t->snaps, &t->bufs, has_colors() ? &t->clrmap : NULL);
+}
+
 void display_text_editor(tedata_t *t)
 {
-	bufs_t *b = &t->bufs;
 	WINDOW *w = t->win;
+	snapshot_t *s;
+
+	sem_wait(&t->draw_sem);
+	if ((s = snapshots_enter(&t->snaps))) {
+		++stats.frames;
+		stats.rows = 0;
+		stats.calls = 0;
+		// Show current file buffer being edited along with echo line buffer where user
+		// enters commands.
+		display_fbuf_damaged_rows(s, w);
+		display_elbuf(s, w);
+		// Active buffer might be the echo line buffer and only want to display one cursor.
+		wmove(w, s->cursor_y, s->cursor_x);
+		wrefresh(w);
+		stats.calls += 2;
+		pthread_mutex_lock(&stats_lock);
+		last_stats = stats;
+		pthread_mutex_unlock(&stats_lock);
+	}
+	snapshots_leave(&t->snaps);
+	sem_post(&t->draw_sem);
+}
 
-	werase(w);
-	// Show current file buffer being edited along with echo line buffer where user enters commands.
-	display_fbuf_lines(b->active_fbuf, w);
-	display_fbuf_lines(&b->elbuf, w);
-	display_syntax_highlighting(&t->clrmap, b->active_fbuf, w);
-	// Active buffer might be the echo line buffer and only want to display one cursor.
-	display_fbuf_cursor(b->active_buf, w);
-	wrefresh(w);
+void display_get_stats(display_stats_t *out_stats)
+{
+	pthread_mutex_lock(&stats_lock);
+	*out_stats = last_stats;
+	pthread_mutex_unlock(&stats_lock);
+}
+
+void display_free(void)
+{
+	if (drawn_rows.array) {
+		dlist_free(&drawn_rows, NULL);
+		dlist_free(&drawn_spans, (dlist_elem_fn)spans_free);
+		dlist_free(&row_cells, NULL);
+	}
 }
@@ -13,11 +13,45 @@
 // Refresh rates in micro seconds.
 #define REFRESH_RATE_60_HZ_USEC 16667
 #define REFRESH_RATE_120_HZ_USEC 8333
-#define REFRESH_RATE_USE_USEC REFRESH_RATE_60_HZ_USEC  // Refresh rate that gets used.
+// Refresh rate that gets used, the most frames drawn in a burst of redraw requests.
+#define REFRESH_RATE_USE_USEC REFRESH_RATE_60_HZ_USEC
 
 /*
- * Display the text editor to the curses standard screen.
+ * Counts of the drawing done by the last display of the text editor.
+ */
+typedef struct display_stats {
+	unsigned long frames;  // Number of times the text editor has been displayed.
+	int rows;  // Rows drawn.
+	int calls;  // Calls made to curses to draw them.
+} display_stats_t;
+
+/*
+ * display_publish - Publish a snapshot of what the display shows of the text editor, to be
+ *	drawn by the next display (see snapshot.h)
+ *
+ * Requires the lock on the text editor data to be held.
+ */
+void display_publish(tedata_t *t);
+
+/*
+ * Display the latest snapshot of the text editor published to the curses standard screen.
+ *
+ * The lock on the text editor data isn't needed, so keys are handled while a frame is drawn.
+ * Only the rows of the file buffer whose line, colours, horizontal scroll or extra cursors
+ * changed since the last display are drawn again.
  */
 void display_text_editor(tedata_t *t);
 
+/*
+ * display_get_stats - Get the counts of the drawing done by the last display
+ *
+ * Can be called by any thread, as the display draws without the lock on the text editor data.
+ */
+void display_get_stats(display_stats_t *out_stats);
+
+/*
+ * display_free - Free what's kept of the last display
+ */
+void display_free(void);
+
 #endif
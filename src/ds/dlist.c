@@ -291,6 +291,76 @@ void dlist_insert(dlist_t *d, int index, void *elem)
 	insert(d, index, elem);
 }
 
+/*
+ * Raise the capacity of the array, if needed, so that n more elements can fit.
+ */
+static void reserve(dlist_t *d, int n)
+{
+	if (d->len+n > d->capacity)
+		resize(d, round_up_pow2(d->len+n));
+}
+
+void dlist_insert_array(dlist_t *d, int index, void *elts, int nelts)
+{
+	if (nelts <= 0)
+		return;
+	reserve(d, nelts);
+	// Unlike insert() the whole tail can be shifted with one call to memmove, which
+	// handles the overlap.
+	memmove(byte_address(d, index+nelts), byte_address(d, index), (d->len-index)*d->eltsz);
+	memcpy(byte_address(d, index), elts, nelts*d->eltsz);
+	d->len += nelts;
+}
+
+/*
+ * Shift the elements after a range of n elements starting at index start left over the top
+ * of the range, shortening the list.
+ */
+static void close_range(dlist_t *d, int start, int n)
+{
+	int end = start+n;
+
+	memmove(byte_address(d, start), byte_address(d, end), (d->len-end)*d->eltsz);
+	d->len -= n;
+	dlist_try_shrink(d);
+}
+
+void dlist_delete_range(dlist_t *d, int start, int n, dlist_elem_fn free_elem)
+{
+	if (n <= 0)
+		return;
+	if (free_elem) {
+		for (int i = start; i < start+n; ++i)
+			free_elem(byte_address(d, i));
+	}
+	close_range(d, start, n);
+}
+
+void dlist_splice_out(dlist_t *d, int start, int n, dlist_t *out_d)
+{
+	if (n <= 0)
+		return;
+	reserve(out_d, n);
+	memcpy(byte_address(out_d, out_d->len), byte_address(d, start), n*d->eltsz);
+	out_d->len += n;
+	close_range(d, start, n);
+}
+
+void dlist_splice_zeroed(dlist_t *d, int start, int nold, int nnew)
+{
+	int n = nnew-nold;
+
+	if (n < 0) {
+		close_range(d, start+nnew, -n);
+	} else if (n > 0) {
+		reserve(d, n);
+		memmove(byte_address(d, start+nnew), byte_address(d, start+nold),
+			(d->len-start-nold)*d->eltsz);
+		memset(byte_address(d, start+nold), 0, n*d->eltsz);
+		d->len += n;
+	}
+}
+
 void dlist_delete_ind(dlist_t *d, int index, dlist_elem_fn free_elem)
 {
 	delete_ind(d, index, free_elem);
@@ -424,5 +494,5 @@ void dlist_resize_len_init_data(dlist_t *l, int new_len, dlist_elem_data_fn init
 
 void dlist_memset(dlist_t *l, unsigned char c)
 {
-	 memset(l->array, c, l->len);
+	memset(l->array, c, l->len*l->eltsz);
 }
@@ -92,6 +92,11 @@ void dlist_append(dlist_t *d, void *elem);
  */
 void dlist_append_init(dlist_t *d, dlist_elem_fn init_elem);
 void dlist_insert(dlist_t *d, int index, void *elem);
+/*
+ * Insert an array of nelts elements at an index. The elements at and after the index are
+ * shifted right once for the whole array rather than once per element.
+ */
+void dlist_insert_array(dlist_t *d, int index, void *elts, int nelts);
 
 /*
  * Remove the last element in the list and optionally store it in out_elem
@@ -105,6 +110,25 @@ void dlist_delete_ind(dlist_t *d, int index, dlist_elem_fn free_elem);
  * Return whether the element was found and deleted.
  */
 bool dlist_delete_elem(dlist_t *d, void *elem, dlist_match_fn mfn, dlist_elem_fn free_elem);
+/*
+ * Delete n consecutive elements starting at an index. The elements after the range are
+ * shifted left once for the whole range rather than once per deleted element.
+ * @free_elem: function to free each deleted element, or NULL if they don't need freeing
+ */
+void dlist_delete_range(dlist_t *d, int start, int n, dlist_elem_fn free_elem);
+/*
+ * Move n consecutive elements starting at an index out of a list and append them to the
+ * end of out_d, which must have the same element size. Same as dlist_delete_range() except
+ * the elements are kept (not freed) by having their bytes moved to out_d.
+ */
+void dlist_splice_out(dlist_t *d, int start, int n, dlist_t *out_d);
+/*
+ * Replace nold consecutive elements starting at an index with nnew, as when a range of
+ * lines that the elements are kept for is replaced. The first of the old elements are kept,
+ * any extra are deleted and any added after them are zeroed, for the caller to set. The
+ * elements after the range are shifted once for the whole range.
+ */
+void dlist_splice_zeroed(dlist_t *d, int start, int nold, int nnew);
 
 /*
  * @fn: function to run on each element in the list
@@ -163,7 +187,7 @@ void dlist_resize_len(dlist_t *l, int new_len);
 void dlist_resize_len_init_data(dlist_t *l, int new_len, dlist_elem_data_fn init_elem, void *data);
 
 /*
- * Fill the allocated memory area of a list with a constant byte c. 
+ * Fill every byte of the elements of a list with a constant byte c.
  */
 void dlist_memset(dlist_t *l, unsigned char c);
 
@@ -0,0 +1,157 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "hmap.h"
+
+/*
+ * Get the key of a slot.
+ */
+static unsigned long *slot_key(hmap_t *h, int i)
+{
+	return (unsigned long *)(h->slots+i*h->slotsz);
+}
+
+/*
+ * Get the value of a slot.
+ */
+static void *slot_val(hmap_t *h, int i)
+{
+	return h->slots+i*h->slotsz+sizeof(unsigned long);
+}
+
+/*
+ * Get the slot a key would be in if there were no collisions.
+ */
+static int home_slot(hmap_t *h, unsigned long key)
+{
+	// Fibonacci hashing spreads sequential keys, such as line versions, across the slots.
+	return (key*0x9e3779b97f4a7c15ul >> 32) & (h->capacity-1);
+}
+
+/*
+ * Get the slot of a key, or the empty slot it would go in if it isn't in the map.
+ */
+static int find_slot(hmap_t *h, unsigned long key)
+{
+	int i = home_slot(h, key);
+
+	while (*slot_key(h, i) && *slot_key(h, i) != key)
+		i = (i+1) & (h->capacity-1);
+	return i;
+}
+
+static void alloc_slots(hmap_t *h, int capacity)
+{
+	h->capacity = capacity;
+	h->slots = calloc(capacity, h->slotsz);
+}
+
+void hmap_init(hmap_t *h, int capacity, size_t valsz)
+{
+	int cap = HMAP_MIN_CAP;
+
+	while (cap < capacity)
+		cap *= 2;
+	h->len = 0;
+	h->valsz = valsz;
+	// Keep keys aligned in every slot.
+	h->slotsz = sizeof(unsigned long) +
+		    (valsz+sizeof(unsigned long)-1)/sizeof(unsigned long)*sizeof(unsigned long);
+	alloc_slots(h, cap);
+}
+
+/*
+ * Run a function on every value in a map.
+ */
+static void for_each_val(hmap_t *h, dlist_elem_fn fn)
+{
+	for (int i = 0; i < h->capacity; ++i) {
+		if (*slot_key(h, i))
+			fn(slot_val(h, i));
+	}
+}
+
+void hmap_free(hmap_t *h, dlist_elem_fn free_val)
+{
+	if (free_val)
+		for_each_val(h, free_val);
+	free(h->slots);
+}
+
+void *hmap_get(hmap_t *h, unsigned long key)
+{
+	int i = find_slot(h, key);
+
+	return *slot_key(h, i) ? slot_val(h, i) : NULL;
+}
+
+/*
+ * Double the number of slots of a map, moving every key into its slot in the new slots.
+ */
+static void grow(hmap_t *h)
+{
+	char *old = h->slots;
+	int oldcap = h->capacity;
+	unsigned long key;
+	int j;
+
+	alloc_slots(h, oldcap*2);
+	for (int i = 0; i < oldcap; ++i) {
+		key = *(unsigned long *)(old+i*h->slotsz);
+		if (key) {
+			j = find_slot(h, key);
+			memcpy(h->slots+j*h->slotsz, old+i*h->slotsz, h->slotsz);
+		}
+	}
+	free(old);
+}
+
+void *hmap_put(hmap_t *h, unsigned long key, void *val)
+{
+	int i;
+
+	// Keep the map at most three quarters full so that probes stay short.
+	if ((h->len+1)*4 > h->capacity*3)
+		grow(h);
+	i = find_slot(h, key);
+	if (!*slot_key(h, i)) {
+		*slot_key(h, i) = key;
+		++h->len;
+	}
+	memcpy(slot_val(h, i), val, h->valsz);
+	return slot_val(h, i);
+}
+
+bool hmap_delete(hmap_t *h, unsigned long key, dlist_elem_fn free_val)
+{
+	int i = find_slot(h, key), j, home;
+
+	if (!*slot_key(h, i))
+		return false;
+	if (free_val)
+		free_val(slot_val(h, i));
+	--h->len;
+
+	// Shift back the keys after the deleted one that would no longer be found past the gap
+	// it leaves, rather than leaving a tombstone.
+	for (j = (i+1) & (h->capacity-1); *slot_key(h, j); j = (j+1) & (h->capacity-1)) {
+		home = home_slot(h, *slot_key(h, j));
+		// Keys whose home slot is cyclically in (i, j] can stay where they are.
+		if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+		memcpy(h->slots+i*h->slotsz, h->slots+j*h->slotsz, h->slotsz);
+		i = j;
+	}
+	*slot_key(h, i) = 0;
+	return true;
+}
+
+void hmap_clear(hmap_t *h, dlist_elem_fn free_val)
+{
+	if (free_val)
+		for_each_val(h, free_val);
+	memset(h->slots, 0, h->capacity*h->slotsz);
+	h->len = 0;
+}
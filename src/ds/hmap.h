@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Hash map from non-zero unsigned long keys to values of a fixed size, using open
+ * addressing with linear probing. Values are stored inline in the map, so the address
+ * of a value is only valid until the map is next changed.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef HMAP_H
+#define HMAP_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "dlist.h"
+
+#define HMAP_MIN_CAP 16
+
+typedef struct hash_map {
+	char *slots;  // Bytes of each slot, a key (0 for an empty slot) followed by its value.
+	int len;  // Number of keys in the map.
+	int capacity;  // Number of slots, a power of 2.
+	size_t valsz;  // Size of a value.
+	size_t slotsz;  // Size of a slot.
+} hmap_t;
+
+/*
+ * hmap_init - Initialise an empty hash map
+ * @capacity: number of slots to start with, rounded up to a power of 2
+ * @valsz: size of a value in the map
+ *
+ * Free with hmap_free().
+ */
+void hmap_init(hmap_t *h, int capacity, size_t valsz);
+
+/*
+ * hmap_free - Free a hash map
+ * @free_val: function to free a value in the map, or NULL if values don't need freeing
+ */
+void hmap_free(hmap_t *h, dlist_elem_fn free_val);
+
+/*
+ * hmap_get - Get the address of the value of a key, or NULL if the key isn't in the map
+ */
+void *hmap_get(hmap_t *h, unsigned long key);
+
+/*
+ * hmap_put - Set the value of a key, adding the key if it isn't in the map
+ * @val: value to copy into the map
+ *
+ * An old value of the key is overwritten without being freed.
+ * Return the address of the value in the map.
+ */
+void *hmap_put(hmap_t *h, unsigned long key, void *val);
+
+/*
+ * hmap_delete - Remove a key and its value from the map
+ * @free_val: see hmap_free()
+ *
+ * Return whether the key was in the map.
+ */
+bool hmap_delete(hmap_t *h, unsigned long key, dlist_elem_fn free_val);
+
+/*
+ * hmap_clear - Remove every key and value from the map
+ * @free_val: see hmap_free()
+ */
+void hmap_clear(hmap_t *h, dlist_elem_fn free_val);
+
+#endif
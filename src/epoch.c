@@ -0,0 +1,59 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "epoch.h"
+
+void epoch_init(epoch_t *e)
+{
+	atomic_init(&e->now, 1);
+	atomic_init(&e->reader, 0);
+	dlist_init(&e->retired, DLIST_MIN_CAP, sizeof(epoch_retired_t));
+}
+
+void epoch_free(epoch_t *e, dlist_elem_fn free_fn)
+{
+	epoch_retired_t *r;
+
+	for (int i = 0; i < e->retired.len; ++i) {
+		r = dlist_get_address(&e->retired, i);
+		free_fn(r->p);
+	}
+	dlist_free(&e->retired, NULL);
+}
+
+void epoch_enter(epoch_t *e)
+{
+	// The accesses are sequentially consistent, so either the writer sees the reader has
+	// entered before it reclaims, or the reader loads what was published before the retire.
+	atomic_store(&e->reader, atomic_load(&e->now));
+}
+
+void epoch_leave(epoch_t *e)
+{
+	atomic_store(&e->reader, 0);
+}
+
+void epoch_retire(epoch_t *e, void *p)
+{
+	epoch_retired_t r = { .p = p, .epoch = atomic_fetch_add(&e->now, 1) };
+
+	dlist_append(&e->retired, &r);
+}
+
+void *epoch_reclaim(epoch_t *e)
+{
+	unsigned long reader = atomic_load(&e->reader);
+	epoch_retired_t *r;
+	void *p;
+
+	if (!e->retired.len)
+		return NULL;
+	r = dlist_get_address(&e->retired, 0);
+	if (reader && reader <= r->epoch)
+		return NULL;
+	p = r->p;
+	dlist_delete_ind(&e->retired, 0, NULL);
+	return p;
+}
@@ -0,0 +1,70 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Epoch based reclamation, deferring the reuse of what a writer replaces until a reader that
+ * could still be reading it is done with it, without the reader ever waiting on the writer.
+ * There's a single reader, and a single writer or writers serialised by a lock, such as the
+ * display reading the snapshots published while handling keys (see snapshot.h).
+ *
+ * The reader enters the current epoch before loading what's published and leaves it once done
+ * with it. What the writer replaces is retired after publishing its replacement, tagged with
+ * the epoch it's retired in, which advances the epoch. It can be reclaimed once the reader
+ * isn't in that epoch or an earlier one, as the reader can then only have loaded what
+ * replaced it.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdatomic.h>
+#include "ds/dlist.h"
+
+typedef struct epoch_retired {
+	void *p;
+	unsigned long epoch;  // Epoch retired in.
+} epoch_retired_t;
+
+typedef struct epoch {
+	atomic_ulong now;  // Current epoch, starting at 1.
+	atomic_ulong reader;  // Epoch the reader entered, 0 while it isn't reading.
+	dlist_t retired;  // Retired (epoch_retired_t), oldest first. Only used by the writer.
+} epoch_t;
+
+/*
+ * epoch_init - Initialise an epoch with nothing retired and no reader in it
+ *
+ * Free with epoch_free().
+ */
+void epoch_init(epoch_t *e);
+
+/*
+ * epoch_free - Free an epoch once the reader is done with it
+ * @free_fn: called with each pointer still retired
+ */
+void epoch_free(epoch_t *e, dlist_elem_fn free_fn);
+
+/*
+ * epoch_enter - Enter the current epoch as the reader, before loading what's published
+ */
+void epoch_enter(epoch_t *e);
+
+/*
+ * epoch_leave - Leave the epoch entered, once done with what was loaded in it
+ */
+void epoch_leave(epoch_t *e);
+
+/*
+ * epoch_retire - Retire what the writer replaced, once its replacement is published
+ */
+void epoch_retire(epoch_t *e, void *p);
+
+/*
+ * epoch_reclaim - Take the oldest retired pointer the reader can no longer be reading, for
+ *	the writer to free or reuse
+ *
+ * Return the pointer, NULL if there's none.
+ */
+void *epoch_reclaim(epoch_t *e);
+
+#endif
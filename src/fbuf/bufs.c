@@ -182,6 +182,9 @@ void bufs_init(bufs_t *b, WINDOW *w, char *fpaths[])
 	b->cmd_istr[0] = '\0';
 	b->cmd_ostr[0] = '\0';
 	stack_init(&b->recent_fbufs, sizeof(int));
+	lines_alloc(&b->reg);
+	search_init(&b->search);
+	b->lock = NULL;
 
 	bufs_open_files(b, w, fpaths);
 	bufs_handle_piped_stdin(b, w);
@@ -198,6 +201,8 @@ void bufs_free(bufs_t *b)
 	fbufs_free(&b->fbufs);
 	elbuf_free(&b->elbuf);
 	dlist_free(&b->recent_fbufs, NULL);
+	lines_free(&b->reg);
+	search_free(&b->search);
 }
 
 static bool fbuf_fpath_eq_fpath(fbuf_t *f, char *fpath)
@@ -227,6 +232,25 @@ int bufs_jump(bufs_t *b, int id)
 	return -1;
 }
 
+bool bufs_find(bufs_t *b, bool reverse)
+{
+	fbuf_t *f = b->active_fbuf;
+	cursor_t *c = &f->cursor;
+	sindex_t *si = fbuf_sindex(f);
+	int row, col;
+	bool found;
+
+	if (reverse)
+		found = search_prev(&b->search, &f->lines, si, c->row, c->col, &row, &col);
+	else
+		found = search_next(&b->search, &f->lines, si, c->row, c->col, &row, &col);
+	if (found) {
+		c->row = row;
+		cursor_set_col_manual(c, col);
+	}
+	return found;
+}
+
 int bufs_write(bufs_t *b)
 {
 	fbuf_t *f;
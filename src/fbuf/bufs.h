@@ -9,9 +9,11 @@
 #define BUFS_H
 
 #include <curses.h>
+#include <semaphore.h>
 #include "../ds/dlist.h"
 #include "../ds/stack.h"
 #include "../chrp.h"
+#include "../search.h"
 #include "fbuf.h"
 #include "elbuf.h"
 
@@ -30,6 +32,14 @@ struct buffers {
 	fbuf_t *active_fbuf;
 	// Total number of buffers made, still keeping count of those deleted.
 	int nbufs;
+	// Register of lines shared by all file buffers. Lines are moved into it by the delete
+	// command, copied into it by the yank command, and copied out of it by the put command.
+	lines_t reg;
+	search_t search;  // Last search, shared by all file buffers so it can be repeated in any.
+	// Lock of the text editor data held while a key is handled, NULL if there is none. A command
+	// waiting on workers can release it so the display keeps updating, as long as nothing
+	// else is edited in the meantime.
+	sem_t *lock;
 	char cmd_istr[256];  // Command input string.
 	char cmd_ostr[512];  // Command output string.
 };
@@ -88,6 +98,15 @@ int bufs_edit(bufs_t *b, char *fpath);
  */
 int bufs_jump(bufs_t *b, int id);
 
+/*
+ * bufs_find - Move the cursor of the active file buffer to the next match of the last
+ *	search, or the previous match if reverse
+ *
+ * Searching resumes from the cursor, which is left on the last match. Return whether
+ * a match was found.
+ */
+bool bufs_find(bufs_t *b, bool reverse);
+
 /*
  * bufs_new - Open a new, empty file buffer
  *
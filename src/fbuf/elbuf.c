@@ -21,11 +21,25 @@ void elbuf_init(elbuf_t *e, WINDOW *w)
 	cursor_reset(&e->cursor);
 	view_init(&e->view, w, -1, 0, 0, 0);
 	elbuf_init_lines(e);
+	// Never has extra cursors, but input to it goes through the same path as file buffers.
+	dlist_init(&e->cursors, DLIST_MIN_CAP, sizeof(cursor_t));
+	e->sindex = NULL;
+	// It's never highlighted, so its states are left empty.
+	hlstates_init(&e->hlstates);
+	e->hlrules = NULL;
+	e->hlgen = 0;
+	// Edits to the echo line go through fbuf_edit(), so it keeps a version for its line even
+	// though it's redrawn every time it's displayed.
+	dlist_init(&e->versions, DLIST_MIN_CAP, sizeof(unsigned long));
+	fbuf_lines_changed(e, 0, 0, e->lines.len);
 }
 
 void elbuf_free(elbuf_t *e)
 {
 	lines_free(&e->lines);
+	dlist_free(&e->cursors, NULL);
+	dlist_free(&e->versions, NULL);
+	hlstates_free(&e->hlstates);
 }
 
 line_t *elbuf_line(elbuf_t *e)
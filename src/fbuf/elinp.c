@@ -23,10 +23,14 @@ void elinp_esc(bufs_t *b)
 void elinp_enter(bufs_t *b, cmds_t *cs, WINDOW *w)
 {
 	elbuf_t *e = &b->elbuf;
+	fbuf_t *f;
 
 	bufs_reset_cmd_strs(b, elbuf_str(e), elbuf_strlen(e));
 	cmds_parse(b->cmd_istr, cs, b, w);
 	elbuf_set(e, b->cmd_ostr);
+	// Command could have moved the cursor of the (possibly new) active file buffer.
+	f = b->active_fbuf;
+	view_sync_cursor(&f->view, &f->cursor, &f->lines);
 
 	// Jump back to file buffer if no string is echoed back.
 	if (strlen(b->cmd_ostr) == 0)
@@ -6,51 +6,75 @@
 #include "fbinp.h"
 
 /*
- * fbinp_left - Move the cursor of a file buffer left by one
+ * Get the line a cursor of a file buffer is on.
  */
-static void fbinp_left(fbuf_t *f)
+static line_t *fbinp_crs_line(fbuf_t *f, cursor_t *c)
 {
-	mv_left(&f->cursor, fbuf_cur_line(f));
+	return dlist_get_address(&f->lines, c->row);
 }
 
 /*
- * fbinp_down - Move the cursor of a file buffer down by one
+ * fbinp_left - Move a cursor of a file buffer left by one
  */
-static void fbinp_down(fbuf_t *f)
+static void fbinp_left(fbuf_t *f, cursor_t *c)
 {
-	mv_down(&f->cursor, &f->lines);
+	mv_left(c, fbinp_crs_line(f, c));
 }
 
 /*
- * fbinp_up - Move the cursor of a file buffer up by one
+ * fbinp_down - Move a cursor of a file buffer down by one
  */
-static void fbinp_up(fbuf_t *f)
+static void fbinp_down(fbuf_t *f, cursor_t *c)
 {
-	mv_up(&f->cursor, &f->lines);
+	mv_down(c, &f->lines);
 }
 
 /*
- * fbinp_right - Move the cursor of a file buffer right by one
+ * fbinp_up - Move a cursor of a file buffer up by one
  */
-static void fbinp_right(fbuf_t *f)
+static void fbinp_up(fbuf_t *f, cursor_t *c)
 {
-	mv_right(&f->cursor, fbuf_cur_line(f));
+	mv_up(c, &f->lines);
 }
 
 /*
- * fbinp_home - Move the cursor of a file buffer to the start of its current line
+ * fbinp_right - Move a cursor of a file buffer right by one
  */
-static void fbinp_home(fbuf_t *f)
+static void fbinp_right(fbuf_t *f, cursor_t *c)
 {
-	mv_start(&f->cursor);
+	mv_right(c, fbinp_crs_line(f, c));
 }
 
 /*
- * fbinp_end - Move the cursor of a file buffer to the end of its current line
+ * fbinp_home - Move a cursor of a file buffer to the start of its current line
  */
-static void fbinp_end(fbuf_t *f)
+static void fbinp_home(fbuf_t *f, cursor_t *c)
 {
-	mv_end(&f->cursor, fbuf_cur_line(f));
+	mv_start(c);
+}
+
+/*
+ * fbinp_end - Move a cursor of a file buffer to the end of its current line
+ */
+static void fbinp_end(fbuf_t *f, cursor_t *c)
+{
+	mv_end(c, fbinp_crs_line(f, c));
+}
+
+/*
+ * fbinp_move - Move the primary cursor and all extra cursors of a file buffer
+ * @mv: function to move a single cursor
+ */
+static void fbinp_move(fbuf_t *f, void (*mv)(fbuf_t *, cursor_t *))
+{
+	mv(f, &f->cursor);
+
+	if (f->cursors.len) {
+		for (int i = 0; i < f->cursors.len; ++i)
+			mv(f, dlist_get_address(&f->cursors, i));
+		// Cursors can meet moving against the start or end of a line.
+		mcursor_normalise(&f->cursor, &f->cursors);
+	}
 }
 
 /*
@@ -69,16 +93,36 @@ static void fbinp_pgdn(fbuf_t *f)
 	mv_view_pgdn(&f->cursor, &f->lines, &f->view);
 }
 
+/*
+ * fbinp_edited_at_cursors - Record an edit made in place on the line of each cursor of
+ *	a file buffer
+ */
+static void fbinp_edited_at_cursors(fbuf_t *f)
+{
+	cursor_t *c;
+
+	fbuf_edit(f, f->cursor.row, 1, 1);
+	for (int i = 0; i < f->cursors.len; ++i) {
+		c = dlist_get_address(&f->cursors, i);
+		fbuf_edit(f, c->row, 1, 1);
+	}
+}
+
 /*
  * fbinp_delete - Delete the current character under the cursor in a file buffer
  */
 static void fbinp_delete(fbuf_t *f)
 {
-	f->unsaved_edit = true;
-
-	if (lins_delete(fbuf_cur_line(f), fbuf_next_line(f), &f->cursor, f->tabsz))
+	if (f->cursors.len) {
+		// Extra cursors don't delete newlines, so that rows stay put.
+		mcursor_edit(&f->lines, &f->cursor, &f->cursors, MCURSOR_DELETE, 0, f->tabsz);
+		fbinp_edited_at_cursors(f);
+	} else if (lins_delete(fbuf_cur_line(f), fbuf_next_line(f), &f->cursor, f->tabsz)) {
 		// Delete next line since merged with current (cursor stay still so still +1 for next).
 		lines_delete(&f->lines, f->cursor.row+1);  
+		fbuf_edit(f, f->cursor.row, 2, 1);
+	} else
+		fbuf_edit(f, f->cursor.row, 1, 1);
 }
 
 /*
@@ -86,11 +130,15 @@ static void fbinp_delete(fbuf_t *f)
  */
 static void fbinp_backspace(fbuf_t *f)
 {
-	f->unsaved_edit = true;
-
-	if (lins_backspace(fbuf_cur_line(f), fbuf_prev_line(f), &f->cursor, f->tabsz))
+	if (f->cursors.len) {
+		mcursor_edit(&f->lines, &f->cursor, &f->cursors, MCURSOR_BACKSPACE, 0, f->tabsz);
+		fbinp_edited_at_cursors(f);
+	} else if (lins_backspace(fbuf_cur_line(f), fbuf_prev_line(f), &f->cursor, f->tabsz)) {
 		// Delete current line since merged with previous (cursor moved up so +1 for "current").
 		lines_delete(&f->lines, f->cursor.row+1);  
+		fbuf_edit(f, f->cursor.row, 2, 1);
+	} else
+		fbuf_edit(f, f->cursor.row, 1, 1);
 }
 
 /*
@@ -100,10 +148,14 @@ static void fbinp_backspace(fbuf_t *f)
 static void fbinp_enter(fbuf_t *f)
 {
 	line_t nl;
+
+	// Splitting lines would shift the rows of the extra cursors, so only split at the primary.
+	fbuf_clear_cursors(f);
 	lins_split(fbuf_cur_line(f), &f->cursor, f->tabsz, &nl);
 	// Cursor got moved down by one so inserting on current line will insert the new line
 	// after the line entered from.
 	dlist_insert(&f->lines, f->cursor.row, &nl);
+	fbuf_edit(f, f->cursor.row-1, 1, 2);
 }
 
 /*
@@ -114,6 +166,15 @@ static void fbinp_esc(bufs_t *b)
 	bufs_active_buf_set_elbuf(b);
 }
 
+/*
+ * fbinp_find - Handle having pressed a key to repeat the last search forwards or in reverse
+ */
+static void fbinp_find(bufs_t *b, bool reverse)
+{
+	if (b->active_buf == b->active_fbuf && !bufs_find(b, reverse))
+		elbuf_set(&b->elbuf, "not found");
+}
+
 /*
  * fbinp_handle_seq_char - Handle having read a sequence-produced character
  */
@@ -122,18 +183,20 @@ static void fbinp_handle_seq_char(bufs_t *b, int c)
 	fbuf_t *f = b->active_buf;
 
 	switch (c) {
-		case KEY_LEFT:	fbinp_left(f); break;
-		case KEY_DOWN:	fbinp_down(f); break;  
-		case KEY_UP:	fbinp_up(f); break;  
-		case KEY_RIGHT:	fbinp_right(f); break;
+		case KEY_LEFT:	fbinp_move(f, fbinp_left); break;
+		case KEY_DOWN:	fbinp_move(f, fbinp_down); break;  
+		case KEY_UP:	fbinp_move(f, fbinp_up); break;  
+		case KEY_RIGHT:	fbinp_move(f, fbinp_right); break;
 
 		case KEY_BACKSPACE:	fbinp_backspace(f); break; 
 
 		case KEY_DC:	fbinp_delete(f); break; 
-		case KEY_HOME:	fbinp_home(f); break;
-		case KEY_END:	fbinp_end(f); break;
+		case KEY_HOME:	fbinp_move(f, fbinp_home); break;
+		case KEY_END:	fbinp_move(f, fbinp_end); break;
 		case KEY_PPAGE:	fbinp_pgup(f); break;
 		case KEY_NPAGE: fbinp_pgdn(f); break;
+		case KEY_F(3):	fbinp_find(b, false); break;
+		case KEY_F(15):	fbinp_find(b, true); break;  // Shift-F3.
 	}
 }
 
@@ -142,7 +205,11 @@ static void fbinp_handle_seq_char(bufs_t *b, int c)
  */
 static void fbinp_insert_char(fbuf_t *f, char c)
 {
-	lins_insert_char(fbuf_cur_line(f), &f->cursor, c, f->tabsz);
+	if (f->cursors.len)
+		mcursor_edit(&f->lines, &f->cursor, &f->cursors, MCURSOR_INSERT, c, f->tabsz);
+	else
+		lins_insert_char(fbuf_cur_line(f), &f->cursor, c, f->tabsz);
+	fbinp_edited_at_cursors(f);
 }
 
 /*
@@ -155,16 +222,12 @@ static void fbinp_handle_reg_char(bufs_t *b, int c)
 
 	if (c == ASCII_ESC)
 		fbinp_esc(b);
-	else {
-		f->unsaved_edit = true;
-
-		if (c == ASCII_BS)
-			fbinp_backspace(f);
-		else if (c == ASCII_ENTER)
-			fbinp_enter(f);
-		else 
-			fbinp_insert_char(f, c);
-	}
+	else if (c == ASCII_BS)
+		fbinp_backspace(f);
+	else if (c == ASCII_ENTER)
+		fbinp_enter(f);
+	else 
+		fbinp_insert_char(f, c);
 }
 
 void fbinp_handle_char(bufs_t *b, int c)
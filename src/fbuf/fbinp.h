@@ -12,6 +12,7 @@
 #include "fbuf.h"
 #include "../move.h"
 #include "../linsert.h"
+#include "../mcursor.h"
 #include "../tedata.h"
 #include "../getch.h"
 
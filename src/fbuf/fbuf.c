@@ -1,6 +1,9 @@
 #include "fbuf.h"
 #include "../misc.h"
 
+// Version given to the next line changed. Starts at 1 so that 0 is never a line's version.
+static unsigned long next_version = 1;
+
 /*
  * Get whether two file buffers are equal.
  * Only uses unique ID for comparison.
@@ -15,6 +18,8 @@ void fbuf_reset_most(fbuf_t *f)
 	f->filepath = NULL;
 	cursor_reset(&f->cursor);
 	f->unsaved_edit = false;
+	f->mark_row = -1;
+	f->sindex = NULL;
 }
 
 void fbuf_reset(fbuf_t *f)
@@ -29,6 +34,30 @@ void fbuf_init_most(fbuf_t *f, WINDOW *w, int tabsz, int id)
 	view_init(&f->view, w, 0, 1, 0, 0);
 	f->tabsz = tabsz;
 	f->id = id;
+	dlist_init(&f->cursors, DLIST_MIN_CAP, sizeof(cursor_t));
+	dlist_init(&f->versions, DLIST_MIN_CAP, sizeof(unsigned long));
+	hlstates_init(&f->hlstates);
+	f->hlrules = NULL;
+	f->hlgen = 0;
+}
+
+/*
+ * Give every line of a file buffer a version, once its lines have been read in.
+ */
+static void fbuf_init_versions(fbuf_t *f)
+{
+	fbuf_lines_changed(f, 0, 0, f->lines.len);
+}
+
+/*
+ * Free the values of a file buffer initialised by fbuf_init_most() when its lines couldn't
+ * be read in.
+ */
+static void fbuf_free_most(fbuf_t *f)
+{
+	dlist_free(&f->cursors, NULL);
+	dlist_free(&f->versions, NULL);
+	hlstates_free(&f->hlstates);
 }
 
 bool fbuf_link(fbuf_t *f, char *fpath)
@@ -58,6 +87,10 @@ void fbuf_free(fbuf_t *f)
 {
 	fbuf_unlink(f);
 	lines_free(&f->lines);
+	dlist_free(&f->cursors, NULL);
+	dlist_free(&f->versions, NULL);
+	hlstates_free(&f->hlstates);
+	sindex_free(f->sindex);
 }
 
 void fbufs_free(fbufs_t *fs)
@@ -70,6 +103,66 @@ bool fbufs_delete_fbuf(fbufs_t *fs, fbuf_t *f)
 	return dlist_delete_elem(fs, f, (dlist_match_fn)fbuf_eq, (dlist_elem_fn)fbuf_free);
 }
 
+void fbuf_set_mark(fbuf_t *f)
+{
+	f->mark_row = f->cursor.row;
+}
+
+void fbuf_clear_mark(fbuf_t *f)
+{
+	f->mark_row = -1;
+}
+
+void fbuf_region(fbuf_t *f, int *out_start, int *out_end)
+{
+	int mark = f->mark_row;
+	int row = f->cursor.row;
+
+	if (mark == -1)
+		mark = row;
+	// Lines could have been removed since the mark was set.
+	else if (mark >= f->lines.len)
+		mark = f->lines.len-1;
+	*out_start = mark < row ? mark : row;
+	*out_end = mark < row ? row : mark;
+}
+
+void fbuf_lines_changed(fbuf_t *f, int row, int nold, int nnew)
+{
+	dlist_splice_zeroed(&f->versions, row, nold, nnew);
+	for (int i = 0; i < nnew; ++i)
+		*(unsigned long *)dlist_get_address(&f->versions, row+i) = next_version++;
+
+	if (f->sindex)
+		sindex_splice(f->sindex, &f->lines, row, nold, nnew);
+	hlstates_splice(&f->hlstates, row, nold, nnew);
+}
+
+void fbuf_edit(fbuf_t *f, int row, int nold, int nnew)
+{
+	f->unsaved_edit = true;
+	fbuf_lines_changed(f, row, nold, nnew);
+}
+
+unsigned long fbuf_line_version(fbuf_t *f, int row)
+{
+	return *(unsigned long *)dlist_get_address(&f->versions, row);
+}
+
+sindex_t *fbuf_sindex(fbuf_t *f)
+{
+	if (!f->sindex && f->lines.len >= SINDEX_MIN_LINES) {
+		f->sindex = sindex_alloc();
+		sindex_build(f->sindex, &f->lines);
+	}
+	return f->sindex;
+}
+
+void fbuf_clear_cursors(fbuf_t *f)
+{
+	dlist_clear(&f->cursors, NULL);
+}
+
 line_t *fbuf_prev_line(fbuf_t *f)
 {
 	int nr = f->cursor.row-1;
@@ -99,12 +192,18 @@ void fbuf_new(fbuf_t *f, WINDOW *w, int tabsz, int id)
 	lines_alloc(&f->lines);
 	// Add a single empty line which the user will start on.
 	dlist_append_init(&f->lines, (dlist_elem_fn)line_alloc);
+	fbuf_init_versions(f);
 }
 
 bool fbuf_new_piped_stdin(fbuf_t *f, WINDOW *w, int tabsz, int id)
 {
 	fbuf_init_most(f, w, tabsz, id);
-	return lines_from_file(&f->lines, STDIN_FILENO, tabsz);
+	if (lines_from_file(&f->lines, STDIN_FILENO, tabsz)) {
+		fbuf_init_versions(f);
+		return true;
+	}
+	fbuf_free_most(f);
+	return false;
 }
 
 void fbuf_fork(fbuf_t *dest, fbuf_t *src, WINDOW *w, int id)
@@ -116,6 +215,12 @@ void fbuf_fork(fbuf_t *dest, fbuf_t *src, WINDOW *w, int id)
 	lines_fork(&src->lines, &dest->lines);
 	dest->tabsz = src->tabsz;
 	dest->view = src->view;
+	dlist_copy_new(&src->cursors, &dest->cursors);
+	// The lines are the same so can keep the same versions and highlighting states.
+	dlist_copy_new(&src->versions, &dest->versions);
+	hlstates_copy_new(&src->hlstates, &dest->hlstates);
+	dest->hlrules = src->hlrules;
+	dest->hlgen = src->hlgen;
 }
 
 /*
@@ -143,15 +248,19 @@ bool fbuf_open(fbuf_t *f, char *fpath, WINDOW *w, int tabsz, int id)
 		// the filepath for the next write to create the underlying file.
 		if (errno == ENOENT) {
 			lines_alloc_empty(&f->lines);
+			fbuf_init_versions(f);
 			return true;
 		}
 		fbuf_unlink(f);
+		fbuf_free_most(f);
 		return false;
 	}
 	read_success = lines_from_file(&f->lines, fd, tabsz);
 	close(fd);
 
-	if (!read_success) 
+	if (read_success)
+		fbuf_init_versions(f);
+	else
 		fbuf_free(f);
 	return read_success;
 }
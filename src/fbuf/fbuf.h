@@ -13,6 +13,8 @@
 #include "../lines.h"
 #include "../cursor.h"
 #include "../view.h"
+#include "../sindex.h"
+#include "../synhl/hlstates.h"
 
 struct file_buffer {
 	// Unique identifier for the file buffer in case there are multiple 
@@ -25,6 +27,24 @@ struct file_buffer {
 	view_t view;  // What the user sees.
 	// Whether the file has been edited since last writing.
 	bool unsaved_edit;
+	// Row the user set a mark on, which along with the cursor row bounds the region of lines
+	// that range commands apply to. -1 when no mark is set.
+	int mark_row;
+	// Extra cursors (cursor_t) on top of the primary cursor above, sorted by position.
+	// An edit made at the primary cursor is also made at each of these.
+	dlist_t cursors;
+	// Search index of the lines, NULL until the file buffer is first searched and only if it
+	// has enough lines to be worth indexing. Kept in sync with the lines by fbuf_edit().
+	sindex_t *sindex;
+	// Version (unsigned long) of each line, in the same order as the lines. A line gets a new
+	// version, unique across all file buffers, whenever it's edited so that the display can
+	// tell which lines changed since it last drew them. Kept in sync by fbuf_lines_changed().
+	dlist_t versions;
+	// States that syntax highlighting starts each line in. Kept in sync by
+	// fbuf_lines_changed().
+	hlstates_t hlstates;
+	void *hlrules;  // Syntax rules the states were found with.
+	unsigned long hlgen;  // Generation of the rules the states were found with, see hlworker_t.
 };
 
 typedef struct file_buffer fbuf_t;
@@ -72,6 +92,60 @@ void fbuf_free(fbuf_t *f);
 void fbufs_free(fbufs_t *fs);
 bool fbufs_delete_fbuf(fbufs_t *fs, fbuf_t *f);
 
+/*
+ * fbuf_set_mark - Set the mark on the row the file buffer's cursor is currently on
+ */
+void fbuf_set_mark(fbuf_t *f);
+/*
+ * fbuf_clear_mark - Unset the mark of a file buffer
+ */
+void fbuf_clear_mark(fbuf_t *f);
+/*
+ * fbuf_region - Get the region of lines between the mark and the cursor row
+ * @out_start: out-param 0-indexed first row of the region (inclusive)
+ * @out_end: out-param 0-indexed last row of the region (inclusive)
+ *
+ * The region is only the cursor row if no mark is set.
+ */
+void fbuf_region(fbuf_t *f, int *out_start, int *out_end);
+
+/*
+ * fbuf_clear_cursors - Remove all of a file buffer's extra cursors, leaving only its
+ *	primary cursor
+ */
+void fbuf_clear_cursors(fbuf_t *f);
+
+/*
+ * fbuf_lines_changed - Record a change to a file buffer's lines, updating its line versions
+ *	and search index
+ * @row: first row changed
+ * @nold: number of rows replaced, counted before the change
+ * @nnew: number of rows that replaced them, counted after the change
+ *
+ * Call after every change to the lines. A line changed in place is 1 row replaced by 1 row.
+ */
+void fbuf_lines_changed(fbuf_t *f, int row, int nold, int nnew);
+
+/*
+ * fbuf_edit - Record an edit made to a file buffer's lines, marking it as having unsaved
+ *	edits along with fbuf_lines_changed()
+ *
+ * See fbuf_lines_changed() for params.
+ */
+void fbuf_edit(fbuf_t *f, int row, int nold, int nnew);
+
+/*
+ * fbuf_line_version - Get the version of a line of a file buffer, see fbuf struct
+ */
+unsigned long fbuf_line_version(fbuf_t *f, int row);
+
+/*
+ * fbuf_sindex - Get the search index of a file buffer, building it on first use
+ *
+ * Return NULL if the file buffer has too few lines to be worth indexing.
+ */
+sindex_t *fbuf_sindex(fbuf_t *f);
+
 /*
  * fbuf_prev_line - Get the line before/above the line the file buffer's cursor is currently on
  *
@@ -3,21 +3,26 @@
  *
  * Copyright (C) 2021 Petar Turukalo
  */
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
 #include "getch.h"
+#include "keydec.h"
 /*
  * TODO backspace doesn't work in the xterm terminal emulator,
  * but home and end do when using xterm terminal emulator with
  * a xterm TERM env
  */
 
-// Maximum number of characters in the escape sequences currently
-// being handled.
-static const int ESC_SEQ_MAX_LEN = 4;
+// Bytes read from the terminal at once.
+#define READ_BUF_SIZE 4096
 
-// Escape sequences produced instead of a single char under some terminals
-// that have the TERM environment variable set to xterm[-256color].
-static const char *XTERM_HOME = "\33[1~";
-static const char *XTERM_END = "\33[4~";
+// Turn bracketed paste on and off, having the terminal mark the start and end of a paste.
+static const char *PASTE_ON = "\33[?2004h";
+static const char *PASTE_OFF = "\33[?2004l";
+
+// Decoder of the bytes read from the terminal when decoding escape sequences.
+static keydec_t dec;
 
 /*
  * Get whether the TERM environment variable is xterm[-256color].
@@ -28,46 +33,89 @@ static bool term_is_xterm(void)
 	return term && strncmp(term, "xterm", 5) == 0;
 }
 
+/*
+ * Wait for stdin to be readable.
+ * @timeout: milli seconds to wait at most, -1 to wait for as long as it takes
+ *
+ * Return whether it's readable.
+ */
+static bool wait_readable(int timeout)
+{
+	struct pollfd p = { .fd = STDIN_FILENO, .events = POLLIN };
+	int n;
+
+	// Interrupted by signal handlers such as on returning to the foreground.
+	while ((n = poll(&p, 1, timeout)) == -1 && errno == EINTR)
+		;
+	return n > 0;
+}
+
 /*
  * Fallback handle the user pressing a key which produced an escape sequence (multiple characters)
- * by converting it into a single char. Return a single char.
+ * by reading the bytes of the terminal straight from stdin, in bulk, and decoding them into
+ * keys ourselves (see keydec.h). An escape waits ESCDELAY for the rest of a sequence.
+ * @wait: whether to block for a key
+ *
+ * Return a key, ERR if not waiting and there's none to read.
  */
-static int mygetch_fallback(void)
+static int mygetch_fallback(bool wait)
 {
-	char s[16];
-	int i, n, c, d;
-	
-	i = 0;
-	n = sizeof(s);
-	bzero(s, n);
+	char buf[READ_BUF_SIZE];
+	bool timed_out = false;
+	int c, n;
 
-	// Hang on to int version of char since might not be ASCII and would lose
-	// its actual value by overflow if only used char version stored in buffer.
-	nodelay(stdscr, false);
-	c = getch();  // Block for a character.
-	s[i++] = c;  
-	
-	// Nonblockingly get characters to fallback handle escape
-	// sequenced characters that curses doesn't handle properly.
-	nodelay(stdscr, true);
-	while (i < n && (d = getch()) != ERR) 
-		s[i++] = d;
-	if (i == ESC_SEQ_MAX_LEN) {
-		if (strncmp(s, XTERM_HOME, i) == 0)
-			return KEY_HOME;
-		if (strncmp(s, XTERM_END, i) == 0)
-			return KEY_END;
+	while ((c = keydec_next(&dec, timed_out)) == ERR) {
+		if (keydec_pending(&dec)) {
+			if ((timed_out = !wait_readable(ESCDELAY)))
+				continue;
+		} else if (!wait_readable(wait ? -1 : 0)) {
+			return ERR;
+		}
+		if ((n = read(STDIN_FILENO, buf, sizeof(buf))) <= 0)
+			return ERR;
+		keydec_feed(&dec, buf, n);
 	}
 	return c;
 }
 
-int mygetch(void)
+/*
+ * Get whether to fallback handle escape sequences, see mygetch_fallback().
+ */
+static bool use_fallback(void)
 {
 	static int fallback = -1;
 	
-	if (fallback == -1)
+	if (fallback == -1) {
 		fallback = term_is_xterm();
-	if (fallback)
-		return mygetch_fallback();
+		if (fallback)
+			keydec_init(&dec);
+	}
+	return fallback;
+}
+
+int mygetch(void)
+{
+	if (use_fallback())
+		return mygetch_fallback(true);
 	return getch();
 }
+
+int mygetch_nowait(void)
+{
+	int c;
+
+	if (use_fallback())
+		return mygetch_fallback(false);
+	nodelay(stdscr, true);
+	c = getch();
+	nodelay(stdscr, false);
+	return c;
+}
+
+void getch_set_paste(bool on)
+{
+	const char *seq = on ? PASTE_ON : PASTE_OFF;
+
+	if (use_fallback() && write(STDOUT_FILENO, seq, strlen(seq)) == -1)
+		return;
+}
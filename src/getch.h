@@ -24,4 +24,20 @@
  */
 int mygetch(void);
 
+/*
+ * mygetch_nowait - Read a single character from stdin like mygetch(), without blocking
+ *
+ * Return ERR if there are no characters to read.
+ */
+int mygetch_nowait(void);
+
+/*
+ * getch_set_paste - Turn bracketed paste on or off in the terminal, when escape sequences
+ *	are decoded by mygetch() rather than curses
+ *
+ * Keys pasted with bracketed paste on are taken literally. Meant to be turned on with curses
+ * and off before leaving the screen to the shell.
+ */
+void getch_set_paste(bool on);
+
 #endif
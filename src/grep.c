@@ -0,0 +1,144 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "grep.h"
+
+/*
+ * Append a result line "path:line: text\n" for a matching row to the results of a job.
+ * The result is allocated once with the tabs of the text realigned after the prefix.
+ */
+static void append_result(grep_job_t *job, int row)
+{
+	line_t *l = dlist_get_address(&job->ls, row);
+	int n = snprintf(NULL, 0, "%s:%d: ", job->path, row+1);
+	line_t res;
+
+	str_alloc(&res, tab_realigned_col(l->array, line_len(l), n, job->tabsz)+1);
+	snprintf(res.array, n+1, "%s:%d: ", job->path, row+1);
+	res.len = tab_realigned_copy(res.array, n, l->array, line_len(l), job->tabsz);
+	res.array[res.len++] = '\n';
+	dlist_append(&job->results, &res);
+}
+
+static void grep_job_run(grep_job_t *job)
+{
+	grep_t *g = job->g;
+	regex_t re;
+	str_t in;
+
+	// Each job compiles its own copy of the regex as glibc locks a regex for the duration
+	// of a regexec() call, which would serialise the workers.
+	if (regcomp(&re, g->pat, REG_EXTENDED|REG_NOSUB) == 0) {
+		if (job->build_index)
+			sindex_build(job->si, &job->ls);
+		str_alloc(&in, 256);
+		for (int row = 0; row < job->ls.len; ++row) {
+			if (job->si && !sindex_may_match(job->si, row, &g->sig))
+				continue;
+			line_contract(dlist_get_address(&job->ls, row), &in);
+			if (regexec(&re, in.array, 0, NULL, 0) == 0)
+				append_result(job, row);
+		}
+		line_free(&in);
+		regfree(&re);
+	}
+
+	pthread_mutex_lock(&g->lock);
+	dlist_append(&g->done, &job);
+	pthread_cond_signal(&g->finished);
+	pthread_mutex_unlock(&g->lock);
+}
+
+bool grep_start(grep_t *g, char *pat, fbufs_t *fs, int tabsz, char *errbuf, int errbufsz)
+{
+	regex_t re;
+	fbuf_t *f;
+	grep_job_t *job;
+	int err;
+
+	if ((err = regcomp(&re, pat, REG_EXTENDED|REG_NOSUB))) {
+		regerror(err, &re, errbuf, errbufsz);
+		return false;
+	}
+	regfree(&re);
+
+	g->pat = pat;
+	tsig_of_regex(pat, &g->sig);
+
+	g->jobs = malloc(fs->len*sizeof(grep_job_t));
+	g->njobs = 0;
+	g->ntaken = 0;
+	pthread_mutex_init(&g->lock, NULL);
+	pthread_cond_init(&g->finished, NULL);
+	dlist_init(&g->done, fs->len, sizeof(grep_job_t *));
+
+	for (int i = 0; i < fs->len; ++i) {
+		f = dlist_get_address(fs, i);
+		if (!fbuf_linked(f))
+			continue;
+		job = g->jobs+g->njobs++;
+		job->g = g;
+		job->path = f->filepath;
+		job->ls = f->lines;
+		job->tabsz = tabsz;
+		// The index is built by the job, so that indexes are built in parallel too.
+		job->build_index = !f->sindex && f->lines.len >= SINDEX_MIN_LINES;
+		if (job->build_index)
+			f->sindex = sindex_alloc();
+		job->si = f->sindex;
+		lines_alloc(&job->results);
+	}
+	// Submitted only once every job is set up, since jobs can finish straight away.
+	for (int i = 0; i < g->njobs; ++i)
+		pool_submit(pool_global(), (pool_job_fn)grep_job_run, g->jobs+i);
+	return true;
+}
+
+void grep_wait(grep_t *g)
+{
+	pthread_mutex_lock(&g->lock);
+	while (!g->done.len && g->ntaken < g->njobs)
+		pthread_cond_wait(&g->finished, &g->lock);
+	pthread_mutex_unlock(&g->lock);
+}
+
+int grep_take(grep_t *g, lines_t *ls)
+{
+	grep_job_t *job;
+	int ntaken = 0;
+
+	pthread_mutex_lock(&g->lock);
+	for (int i = 0; i < g->done.len; ++i) {
+		dlist_get(&g->done, i, &job);
+		// Results end in a newline so go before the last line.
+		dlist_insert_array(ls, ls->len-1, job->results.array, job->results.len);
+		ntaken += job->results.len;
+		job->results.len = 0;  // Lines now belong to ls.
+	}
+	g->ntaken += g->done.len;
+	dlist_resize_len(&g->done, 0);
+	pthread_mutex_unlock(&g->lock);
+	return ntaken;
+}
+
+bool grep_finished(grep_t *g)
+{
+	return g->ntaken == g->njobs;
+}
+
+void grep_free(grep_t *g)
+{
+	pthread_mutex_lock(&g->lock);
+	while (g->ntaken+g->done.len < g->njobs)
+		pthread_cond_wait(&g->finished, &g->lock);
+	pthread_mutex_unlock(&g->lock);
+
+	for (int i = 0; i < g->njobs; ++i)
+		dlist_free(&g->jobs[i].results, (dlist_elem_fn)line_free);
+	free(g->jobs);
+	dlist_free(&g->done, NULL);
+	pthread_cond_destroy(&g->finished);
+	pthread_mutex_destroy(&g->lock);
+}
@@ -0,0 +1,87 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Searching the lines of many file buffers for the matches of a regex at once,
+ * with a job per file buffer run by the global pool (see pool.h). The results of
+ * each job can be taken as soon as it finishes.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef GREP_H
+#define GREP_H
+
+#include <regex.h>
+#include <pthread.h>
+#include "fbuf/fbuf.h"
+#include "pool.h"
+#include "sindex.h"
+
+struct grep;
+
+/*
+ * Search of the lines of a file buffer, run as a pool job.
+ */
+typedef struct grep_job {
+	struct grep *g;
+	char *path;  // Filepath of the file buffer.
+	// Copy of the file buffer's lines struct, since file buffers can move in their list while
+	// the job runs. The lines themselves mustn't be edited until the grep is finished.
+	lines_t ls;
+	int tabsz;  // Tab size of the result lines.
+	sindex_t *si;  // Search index of the file buffer's lines, NULL if it has none.
+	bool build_index;  // Whether the job builds si before searching with it.
+	lines_t results;  // Out-param lines "path:line: text\n" of each matching line.
+} grep_job_t;
+
+typedef struct grep {
+	char *pat;  // POSIX extended regex pattern.
+	// Trigram signature of a string every match of pat contains, for skipping lines with
+	// the search index of a file buffer. Empty if no such string could be found.
+	tsig_t sig;
+	grep_job_t *jobs;
+	int njobs;
+	int ntaken;  // Number of finished jobs whose results have been taken.
+	// Lock which must be acquired before accessing the fields below.
+	pthread_mutex_t lock;
+	pthread_cond_t finished;  // Signalled when a job finishes.
+	// Queue of grep_job_t * which have finished and whose results haven't been taken yet.
+	dlist_t done;
+} grep_t;
+
+/*
+ * grep_start - Start searching the lines of every linked file buffer for the matches of a regex
+ * @pat: regex pattern, which must outlive the grep
+ * @errbuf: out-param error message if the pattern couldn't be compiled
+ * @errbufsz: size of errbuf
+ *
+ * Unlinked file buffers, such as earlier grep results, aren't searched. The lines of the file
+ * buffers mustn't be edited until grep_finished() is true. Large file buffers without a search
+ * index have one built by their job. Free with grep_free().
+ * Return whether the pattern could be compiled, and so the grep was started.
+ */
+bool grep_start(grep_t *g, char *pat, fbufs_t *fs, int tabsz, char *errbuf, int errbufsz);
+
+/*
+ * grep_wait - Wait until there are results to take, or every job's results have been taken
+ */
+void grep_wait(grep_t *g);
+
+/*
+ * grep_take - Move the results of the jobs that have finished since the last take to the end
+ *	of lines, in the order the jobs finished
+ *
+ * The last line of ls is kept last. Return the number of results taken.
+ */
+int grep_take(grep_t *g, lines_t *ls);
+
+/*
+ * grep_finished - Get whether the results of every job have been taken
+ */
+bool grep_finished(grep_t *g);
+
+/*
+ * grep_free - Wait for a grep to finish and free it
+ */
+void grep_free(grep_t *g);
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include "istats.h"
+
+static input_stats_t stats;
+// Whether there are keys handled that haven't been drawn, and when the first of them was read.
+static bool undrawn;
+static struct timespec undrawn_since;
+// Lock of the counts above, as keys are handled and drawn on different threads.
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+void istats_batch(int nkeys, struct timespec *read_at)
+{
+	pthread_mutex_lock(&lock);
+	stats.keys += nkeys;
+	++stats.batches;
+	stats.last_batch = nkeys;
+	if (nkeys > stats.max_batch)
+		stats.max_batch = nkeys;
+	if (!undrawn) {
+		undrawn = true;
+		undrawn_since = *read_at;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void istats_drawn(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	pthread_mutex_lock(&lock);
+	if (undrawn) {
+		stats.last_latency_usec = (now.tv_sec-undrawn_since.tv_sec)*1000000L +
+					  (now.tv_nsec-undrawn_since.tv_nsec)/1000;
+		if (stats.last_latency_usec > stats.max_latency_usec)
+			stats.max_latency_usec = stats.last_latency_usec;
+		undrawn = false;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void istats_get(input_stats_t *out_stats)
+{
+	pthread_mutex_lock(&lock);
+	*out_stats = stats;
+	pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,44 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Counts of the batches of keys handled, and how long keys take to be drawn. Keys read
+ * together are handled as a batch under a single acquisition of the lock on the text editor
+ * data, with a single redraw. The counts have their own lock, as keys are drawn by the display
+ * without the lock on the text editor data, so can be called by any thread.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef ISTATS_H
+#define ISTATS_H
+
+#include <time.h>
+
+typedef struct input_stats {
+	unsigned long keys;  // Keys handled.
+	unsigned long batches;  // Batches the keys were handled in.
+	int last_batch;  // Keys in the last batch.
+	int max_batch;  // Most keys in a batch.
+	// Micro seconds from reading the first key not yet drawn to drawing it, for the last frame
+	// drawing keys and the slowest of them.
+	long last_latency_usec;
+	long max_latency_usec;
+} input_stats_t;
+
+/*
+ * istats_batch - Count a batch of keys handled
+ * @nkeys: number of keys in the batch
+ * @read_at: time the first key of the batch was read, on the monotonic clock
+ */
+void istats_batch(int nkeys, struct timespec *read_at);
+
+/*
+ * istats_drawn - Count a frame drawn, which draws the keys handled since the last frame
+ */
+void istats_drawn(void);
+
+/*
+ * istats_get - Get the counts of the keys handled so far
+ */
+void istats_get(input_stats_t *out_stats);
+
+#endif
@@ -0,0 +1,240 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "keydec.h"
+#include "getch.h"
+#include "misc.h"
+
+// Most bytes in an escape sequence, past which it's taken to be bytes that only look like one.
+#define KEYDEC_MAX_SEQ 32
+
+// Results of decoding a sequence that aren't keys: a sequence to drop, such as an unknown
+// one, and the start and end of a bracketed paste.
+enum {
+	SEQ_NONE = -2,
+	SEQ_PASTE_START = -3,
+	SEQ_PASTE_END = -4,
+};
+
+static const char *PASTE_END = "\33[201~";
+
+/*
+ * Key of a sequence.
+ * @code: final byte of the sequence, or its number for a sequence ending in '~'
+ * @key: key without modifiers
+ * @shift_key: key with shift, 0 if curses doesn't have a key for it
+ * @fn: number of the function key of the sequence, 0 if it isn't for one
+ */
+struct seq_key {
+	int code;
+	int key;
+	int shift_key;
+	int fn;
+};
+
+// Keys of sequences by their final byte, as sent with CSI or SS3.
+static const struct seq_key FINAL_KEYS[] = {
+	{ 'A', KEY_UP, KEY_SR }, { 'B', KEY_DOWN, KEY_SF },
+	{ 'C', KEY_RIGHT, KEY_SRIGHT }, { 'D', KEY_LEFT, KEY_SLEFT },
+	{ 'H', KEY_HOME, KEY_SHOME }, { 'F', KEY_END, KEY_SEND },
+	{ 'E', KEY_B2 }, { 'Z', KEY_BTAB },
+	{ 'P', 0, 0, 1 }, { 'Q', 0, 0, 2 }, { 'R', 0, 0, 3 }, { 'S', 0, 0, 4 },
+};
+
+// Keys of CSI sequences ending in '~' by their number.
+static const struct seq_key TILDE_KEYS[] = {
+	{ 1, KEY_HOME, KEY_SHOME }, { 2, KEY_IC, KEY_SIC }, { 3, KEY_DC, KEY_SDC },
+	{ 4, KEY_END, KEY_SEND }, { 5, KEY_PPAGE, KEY_SPREVIOUS }, { 6, KEY_NPAGE, KEY_SNEXT },
+	{ 7, KEY_HOME, KEY_SHOME }, { 8, KEY_END, KEY_SEND },
+	{ 11, 0, 0, 1 }, { 12, 0, 0, 2 }, { 13, 0, 0, 3 }, { 14, 0, 0, 4 }, { 15, 0, 0, 5 },
+	{ 17, 0, 0, 6 }, { 18, 0, 0, 7 }, { 19, 0, 0, 8 }, { 20, 0, 0, 9 }, { 21, 0, 0, 10 },
+	{ 23, 0, 0, 11 }, { 24, 0, 0, 12 },
+	{ 200, SEQ_PASTE_START }, { 201, SEQ_PASTE_END },
+};
+
+// Number added to the number of a function key for each modifier parameter (2 for shift,
+// 3 alt, 5 control, and their sums), as curses numbers function keys with modifiers under
+// xterm. Modifiers it doesn't number are dropped.
+static const int FKEY_MOD_OFFSET[] = { [2] = 12, [3] = 48, [4] = 60, [5] = 24, [6] = 36 };
+
+void keydec_init(keydec_t *k)
+{
+	dlist_init(&k->bytes, DLIST_MIN_CAP, sizeof(char));
+	k->pos = 0;
+	k->paste = false;
+}
+
+void keydec_free(keydec_t *k)
+{
+	dlist_free(&k->bytes, NULL);
+}
+
+void keydec_feed(keydec_t *k, char *bytes, int n)
+{
+	// Drop the bytes decoded so far, which are usually all of them.
+	dlist_delete_range(&k->bytes, 0, k->pos, NULL);
+	k->pos = 0;
+	dlist_insert_array(&k->bytes, k->bytes.len, bytes, n);
+}
+
+bool keydec_pending(keydec_t *k)
+{
+	return k->pos < k->bytes.len;
+}
+
+/*
+ * Look up the key of a sequence in a table.
+ * @mod: modifier parameter of the sequence, 1 for none
+ */
+static int seq_key(const struct seq_key *keys, int nkeys, int code, int mod)
+{
+	for (int i = 0; i < nkeys; ++i) {
+		if (keys[i].code != code)
+			continue;
+		if (keys[i].fn)
+			return KEY_F(keys[i].fn+(mod < ARRAY_LEN(FKEY_MOD_OFFSET) ?
+						 FKEY_MOD_OFFSET[mod] : 0));
+		if (mod == 2 && keys[i].shift_key)
+			return keys[i].shift_key;
+		return keys[i].key;
+	}
+	return SEQ_NONE;
+}
+
+/*
+ * Parse a CSI or SS3 sequence, its parameters being numbers separated by ';'.
+ * @s: bytes after the ESC starting the sequence
+ * @n: number of bytes
+ * @out_key: out-param key of the sequence, SEQ_NONE for an unknown sequence
+ *
+ * Return the length of the sequence, 0 if the bytes end before it does, or -1 if it's not a
+ * valid sequence.
+ */
+static int parse_seq(char *s, int n, int *out_key)
+{
+	int params[2] = { 0, 0 }, nparams = 1;
+	bool known = true;
+	int mod, i;
+	char c;
+
+	for (i = 1; i < n && i < KEYDEC_MAX_SEQ; ++i) {
+		c = s[i];
+		if (c >= '0' && c <= '9') {
+			if (nparams <= 2 && params[nparams-1] < 1000)
+				params[nparams-1] = params[nparams-1]*10 + c-'0';
+		} else if (c == ';') {
+			++nparams;
+		} else if (c >= 0x20 && c <= 0x3f) {
+			// Private parameters and intermediate bytes, which no keys are sent with.
+			known = false;
+		} else if (c >= 0x40 && c <= 0x7e) {
+			break;
+		} else {
+			return -1;
+		}
+	}
+	if (i == KEYDEC_MAX_SEQ)
+		return -1;
+	if (i == n)
+		return 0;
+
+	// SS3 sequences have the modifier as their only parameter.
+	mod = s[0] == 'O' ? params[0] : nparams >= 2 ? params[1] : 1;
+	if (!known)
+		*out_key = SEQ_NONE;
+	else if (c == '~')
+		*out_key = seq_key(TILDE_KEYS, ARRAY_LEN(TILDE_KEYS), params[0], mod ? mod : 1);
+	else
+		*out_key = seq_key(FINAL_KEYS, ARRAY_LEN(FINAL_KEYS), c, mod ? mod : 1);
+	return i+1;
+}
+
+/*
+ * Match the bytes left to decode against the start of a string.
+ * Return 1 if they start with the string, 0 if they end before it does but match so far,
+ * or -1 if they don't match.
+ */
+static int match_prefix(char *s, int n, const char *prefix)
+{
+	int i;
+
+	for (i = 0; i < n && prefix[i]; ++i) {
+		if (s[i] != prefix[i])
+			return -1;
+	}
+	return prefix[i] ? 0 : 1;
+}
+
+/*
+ * Decode the next key or sequence. Return the key, SEQ_NONE for a sequence without one, or
+ * ERR if more bytes are needed.
+ */
+static int decode(keydec_t *k, bool timed_out)
+{
+	char *s = k->bytes.array+k->pos;
+	int n = k->bytes.len-k->pos;
+	int len, key;
+
+	if (!n)
+		return ERR;
+	// Curses has the terminal send enter as a carriage return, translating it to a newline
+	// itself, as is done here.
+	if (s[0] == '\r') {
+		++k->pos;
+		return ASCII_ENTER;
+	}
+	if (s[0] != ASCII_ESC) {
+		++k->pos;
+		return (unsigned char)s[0];
+	}
+
+	if (k->paste) {
+		switch (match_prefix(s, n, PASTE_END)) {
+		case 1:
+			k->pos += strlen(PASTE_END);
+			k->paste = false;
+			return SEQ_NONE;
+		case 0:
+			if (!timed_out)
+				return ERR;
+			break;
+		}
+		// A pasted escape would be taken for the escape key, so is dropped, leaving the rest
+		// of any sequence it starts as the characters they are.
+		++k->pos;
+		return SEQ_NONE;
+	}
+
+	// An escape not followed by a sequence is the escape key, or alt pressed with the key
+	// after it, which is decoded on its own.
+	if (n == 1 && !timed_out)
+		return ERR;
+	if (n == 1 || (s[1] != '[' && s[1] != 'O')) {
+		++k->pos;
+		return ASCII_ESC;
+	}
+	if (!(len = parse_seq(s+1, n-1, &key)) && !timed_out)
+		return ERR;
+	if (len <= 0) {
+		++k->pos;
+		return ASCII_ESC;
+	}
+	k->pos += 1+len;
+
+	if (key == SEQ_PASTE_START) {
+		k->paste = true;
+		return SEQ_NONE;
+	}
+	return key == SEQ_PASTE_END ? SEQ_NONE : key;
+}
+
+int keydec_next(keydec_t *k, bool timed_out)
+{
+	int key;
+
+	while ((key = decode(k, timed_out)) == SEQ_NONE)
+		;
+	return key;
+}
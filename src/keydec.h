@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Decoder of the raw bytes read from a terminal into keys. Escape sequences are decoded as
+ * CSI (ESC [) or SS3 (ESC O) sequences of parameters and a final byte, looked up in tables
+ * of the keys they're for, with any modifiers as sent by xterm. Unknown sequences are
+ * dropped rather than coming out as stray characters. Bracketed pastes are taken literally
+ * but for escapes, which are dropped so that an escape pasted is never taken for a key.
+ *
+ * Keys are the characters read, or curses KEY_* codes for keys decoded from sequences.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef KEYDEC_H
+#define KEYDEC_H
+
+#include <stdbool.h>
+#include <curses.h>
+#include "ds/dlist.h"
+
+typedef struct keydec {
+	dlist_t bytes;  // Bytes (char) fed that haven't been decoded.
+	int pos;  // Index in bytes of the next byte to decode.
+	bool paste;  // Whether the bytes are in a bracketed paste.
+} keydec_t;
+
+/*
+ * keydec_init - Initialise a decoder without any bytes to decode
+ *
+ * Free with keydec_free().
+ */
+void keydec_init(keydec_t *k);
+
+/*
+ * keydec_free - Free a decoder
+ */
+void keydec_free(keydec_t *k);
+
+/*
+ * keydec_feed - Give a decoder bytes read from the terminal to decode
+ * @n: number of bytes
+ */
+void keydec_feed(keydec_t *k, char *bytes, int n);
+
+/*
+ * keydec_pending - Get whether a decoder has bytes left that it hasn't decoded, such as the
+ *	start of an escape sequence waiting on the rest of it
+ */
+bool keydec_pending(keydec_t *k);
+
+/*
+ * keydec_next - Decode the next key from the bytes fed to a decoder
+ * @timed_out: whether the terminal has sent nothing more for long enough that the bytes
+ *	left are all there is, so that an escape on its own is decoded as the escape key rather
+ *	than waiting for the rest of a sequence
+ *
+ * Return the key decoded, or ERR if more bytes are needed to decode one.
+ */
+int keydec_next(keydec_t *k, bool timed_out);
+
+#endif
@@ -28,6 +28,26 @@ int line_len_nl(line_t *l)
 	return l->len;
 }
 
+void line_contract(line_t *l, str_t *out)
+{
+	int i, j, n = line_len(l);
+
+	out->len = 0;
+	for (i = 0; i < n; i = j) {
+		for (j = i; j < n && l->array[j] != TAB_CONT; ++j)
+			;
+		dlist_insert_array(out, out->len, l->array+i, j-i);
+		for (; j < n && l->array[j] == TAB_CONT; ++j)
+			;
+	}
+	for (i = 0; i < out->len; ++i) {
+		if (out->array[i] == TAB_START)
+			out->array[i] = '\t';
+	}
+	str_append(out, '\0');
+	--out->len;  // Null-terminated but not counted.
+}
+
 void line_split(line_t *l, int col, int tabsz, line_t *newline)
 {
 	dlist_split(l, col, newline);
@@ -35,6 +35,13 @@ int line_len(line_t *l);
  */
 int line_len_nl(line_t *l);
 
+/*
+ * line_contract - Copy a line, excluding its newline, to a null-terminated string with its
+ *	tabs contracted back to '\t', as the text appears in the file
+ * @out: out-param string to copy to, overwritten
+ */
+void line_contract(line_t *l, str_t *out);
+
 /*
  * line_split - Split a line into two
  * @l: line to split, becomes the left part of the split
@@ -124,6 +124,106 @@ void lines_delete(lines_t *ls, int nr)
 	dlist_delete_ind(ls, nr, (dlist_elem_fn)line_free);
 }
 
+/*
+ * Add a newline to the end of a line if it doesn't already have one.
+ */
+static void line_ensure_newline(line_t *l)
+{
+	if (line_len(l) == line_len_nl(l))
+		str_append(l, '\n');
+}
+
+/*
+ * Remove the newline off the end of a line if it has one.
+ */
+static void line_remove_newline(line_t *l)
+{
+	if (line_len(l) != line_len_nl(l))
+		dlist_pop(l, NULL);
+}
+
+void lines_cut(lines_t *ls, int start, int end, lines_t *out_ls)
+{
+	int n = end-start+1;
+
+	// Only the last line can be missing a newline.
+	if (end == ls->len-1)
+		line_ensure_newline(dlist_get_address(ls, end));
+	if (out_ls)
+		dlist_splice_out(ls, start, n, out_ls);
+	else
+		dlist_delete_range(ls, start, n, (dlist_elem_fn)line_free);
+
+	if (ls->len == 0)
+		dlist_append_init(ls, (dlist_elem_fn)line_alloc);
+	else if (start == ls->len)
+		// Cut off the end, so what was the second last line is now last.
+		line_remove_newline(dlist_get_address(ls, ls->len-1));
+}
+
+void lines_copy_range(lines_t *ls, int start, int end, lines_t *out_ls)
+{
+	line_t l;
+
+	for (int i = start; i <= end; ++i) {
+		dlist_copy_new(dlist_get_address(ls, i), &l);
+		line_ensure_newline(&l);
+		dlist_append(out_ls, &l);
+	}
+}
+
+void lines_put(lines_t *ls, int row, lines_t *src)
+{
+	lines_t copy;
+	bool put_last = row == ls->len-1;
+
+	if (!src->len)
+		return;
+	lines_alloc(&copy);
+	lines_copy_range(src, 0, src->len-1, &copy);
+
+	if (put_last)
+		line_ensure_newline(dlist_get_address(ls, row));
+	dlist_insert_array(ls, row+1, copy.array, copy.len);
+	if (put_last)
+		line_remove_newline(dlist_get_address(ls, ls->len-1));
+	// The lines themselves now belong to ls, so only free the list holding them.
+	dlist_free(&copy, NULL);
+}
+
+/*
+ * Get the number of characters of a line that are kept when it's joined with the lines in
+ * a range: all lines but the last in the range lose their newline.
+ */
+static int line_join_len(lines_t *ls, int i, int end)
+{
+	line_t *l = dlist_get_address(ls, i);
+	return i == end ? line_len_nl(l) : line_len(l);
+}
+
+void lines_join(lines_t *ls, int start, int end, int tabsz)
+{
+	line_t joined, *l;
+	int i, col = 0;
+
+	for (i = start; i <= end; ++i) {
+		l = dlist_get_address(ls, i);
+		col = tab_realigned_col(l->array, line_join_len(ls, i, end), col, tabsz);
+	}
+	str_alloc(&joined, col);
+
+	col = 0;
+	for (i = start; i <= end; ++i) {
+		l = dlist_get_address(ls, i);
+		col = tab_realigned_copy(joined.array, col, l->array, line_join_len(ls, i, end), tabsz);
+	}
+	joined.len = col;
+
+	line_free(dlist_get_address(ls, start));
+	dlist_set(ls, start, &joined);
+	dlist_delete_range(ls, start+1, end-start, (dlist_elem_fn)line_free);
+}
+
 static void lines_append_forked_line(line_t *line, lines_t *out_lines)
 {
 	line_t l;
@@ -47,6 +47,45 @@ int lines_write(lines_t *ls, int tabsz, int fd);
  */
 void lines_delete(lines_t *l, int nr);
 
+/*
+ * lines_cut - Remove a range of lines from a list of lines in a single splice
+ * @start: 0-indexed line number of the first line in the range (inclusive)
+ * @end: 0-indexed line number of the last line in the range (inclusive)
+ * @out_ls: lines to move the removed lines onto the end of without copying them, or NULL
+ *	to free them instead
+ *
+ * Every line moved to out_ls ends in a newline. The line left last in ls has its newline
+ * removed, and ls is left with a single empty line if all of its lines were removed.
+ */
+void lines_cut(lines_t *ls, int start, int end, lines_t *out_ls);
+
+/*
+ * lines_copy_range - Append copies of a range of lines onto the end of out_ls
+ *
+ * See lines_cut() for params. Every copied line ends in a newline.
+ */
+void lines_copy_range(lines_t *ls, int start, int end, lines_t *out_ls);
+
+/*
+ * lines_put - Insert copies of lines after a line in a single splice
+ * @row: 0-indexed line number of the line to insert after
+ * @src: lines to insert, each expected to end in a newline (see lines_cut())
+ *
+ * Keeps the last line of ls without a newline.
+ */
+void lines_put(lines_t *ls, int row, lines_t *src);
+
+/*
+ * lines_join - Join a range of lines into a single line by removing the newlines between them
+ * @start: 0-indexed line number of the first line in the range, which becomes the joined line
+ * @end: 0-indexed line number of the last line in the range (inclusive)
+ *
+ * The length of the joined line is computed up front so it's built with a single allocation,
+ * and tabs are realigned as the lines are copied into it. O(n) worst case time complexity where
+ * n is the total length of the lines.
+ */
+void lines_join(lines_t *ls, int start, int end, int tabsz);
+
 /*
  * Create a new copy of lines from existing lines
  */
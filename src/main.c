@@ -5,53 +5,335 @@
  */
 #include <pthread.h>
 #include <signal.h>
+#include <time.h>
 #include "tedata.h"
+#include "redraw.h"
 #include "sig.h"
 #include "display.h"
 #include "getch.h"
+#include "istats.h"
 #include "fbuf/fbinp.h"
 #include "fbuf/elinp.h"
 #include "log.h"
+#include "misc.h"
+#include <unistd.h>
+#include <sys/ioctl.h>
+#ifdef TEDIT_REACTOR
+#include <errno.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include "reactor.h"
+#endif
 
 static tedata_t t = { 0 };  // Global text editor data.
 
+// Signals handled by the event loop, read from a signalfd, or else by the signal thread, in
+// between frames (see signal_start()). Blocked so that they're only taken there.
+static const int HANDLED_SIGNALS[] = { SIGWINCH, SIGTERM, SIGTSTP, SIGCONT };
+
+/*
+ * Handle a key read from the user by having it affect the current buffer.
+ * Requires the lock on the text editor data to be held.
+ */
+static void handle_key(tedata_t *t, int c)
+{
+	fbuf_t *f = t->bufs.active_buf;
+
+	if (f == t->bufs.active_fbuf)
+		fbinp_handle_char(&t->bufs, c);
+	else
+		elinp_handle_char(&t->bufs, c, &t->cmds, t->win);
+	// Synced after every key rather than once per batch, as a page move is only carried
+	// over to the view by the next sync.
+	view_sync_cursor(&f->view, &f->cursor, &f->lines);
+}
+
+/*
+ * Handle a batch of keys: a key read from the user, then every key read after it without
+ * waiting, as in key repeat or a paste, so that the lock is acquired and a redraw requested
+ * once for them all. Requires the lock on the text editor data to be held.
+ * @read_at: time the first key was read
+ */
+static void handle_keys(tedata_t *t, int c, struct timespec *read_at)
+{
+	int n = 0;
+
+	do {
+		handle_key(t, c);
+		++n;
+	} while ((c = mygetch_nowait()) != ERR);
+	istats_batch(n, read_at);
+}
+
+/*
+ * Get the number of micro seconds from one time to another.
+ */
+static long usec_between(struct timespec *from, struct timespec *to)
+{
+	return (to->tv_sec-from->tv_sec)*1000000L + (to->tv_nsec-from->tv_nsec)/1000;
+}
+
+/*
+ * Get the set of signals handled.
+ */
+static void handled_sigset(sigset_t *out_set)
+{
+	sigemptyset(out_set);
+	for (int i = 0; i < ARRAY_LEN(HANDLED_SIGNALS); ++i)
+		sigaddset(out_set, HANDLED_SIGNALS[i]);
+}
+
+/*
+ * Resize curses to the size of the terminal, done here as the signal curses would resize on
+ * is blocked, to be taken by the event loop or signal thread instead. Keys aren't all read
+ * with curses either (see getch.h), so it wouldn't see a resize to report.
+ */
+static void resize_curses(void)
+{
+	struct winsize ws;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1)
+		return;
+	resizeterm(ws.ws_row, ws.ws_col);
+	redraw_request();
+}
+
+#ifdef TEDIT_REACTOR
+/*
+ * State of the event loop running the text editor on a single thread.
+ */
+typedef struct editor_loop {
+	tedata_t *t;
+	int timerfd;  // Timer waiting out the refresh period before drawing a frame.
+	bool timer_armed;  // Whether a frame is waiting on the timer.
+	struct timespec last;  // When the last frame was drawn.
+} editor_loop_t;
+
+static void draw_frame(editor_loop_t *l)
+{
+	display_publish(l->t);
+	display_text_editor(l->t);
+	istats_drawn();
+	clock_gettime(CLOCK_MONOTONIC, &l->last);
+}
+
+/*
+ * Handle keys from the user, handling every key read so far before the next frame.
+ */
+static void on_tty(int fd, editor_loop_t *l)
+{
+	struct timespec read_at;
+	int c;
+
+	if ((c = mygetch_nowait()) == ERR)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &read_at);
+	handle_keys(l->t, c, &read_at);
+	redraw_request();
+}
+
+/*
+ * Draw a frame for the redraws requested. A request straight after the last frame waits out
+ * the rest of the refresh period on the timer, so that a burst of keys is drawn in one frame.
+ */
+static void on_redraw(int fd, editor_loop_t *l)
+{
+	struct itimerspec its = { 0 };
+	struct timespec now;
+	long since_last;
+
+	redraw_drain();
+	if (l->timer_armed)
+		return;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	since_last = usec_between(&l->last, &now);
+	if (since_last >= REFRESH_RATE_USE_USEC) {
+		draw_frame(l);
+		return;
+	}
+	its.it_value.tv_nsec = (REFRESH_RATE_USE_USEC-since_last)*1000;
+	timerfd_settime(l->timerfd, 0, &its, NULL);
+	l->timer_armed = true;
+}
+
+static void on_timer(int fd, editor_loop_t *l)
+{
+	uint64_t expirations;
+
+	if (read(fd, &expirations, sizeof(expirations)) == -1)
+		return;
+	l->timer_armed = false;
+	draw_frame(l);
+}
+
+static void on_signal(int fd, editor_loop_t *l)
+{
+	struct signalfd_siginfo si;
+
+	while (read(fd, &si, sizeof(si)) == sizeof(si)) {
+		switch (si.ssi_signo) {
+		case SIGWINCH:
+			resize_curses();
+			break;
+		case SIGTERM:
+			exit(EXIT_SUCCESS);
+		case SIGTSTP:
+			// Stopping can't be blocked, unlike SIGTSTP, so is used to stop. Execution
+			// carries on from here on returning to the foreground, with SIGCONT to read.
+			sig_leave_curses();
+			raise(SIGSTOP);
+			break;
+		case SIGCONT:
+			sig_return_to_curses();
+			break;
+		}
+	}
+}
+
 /*
- * Start the user input main loop. Each loop a key is read from the user
- * and that key handled by having it affect the current file buffer.
+ * Run the text editor on a single thread with an event loop, instead of the input and
+ * display threads, so that handling a key and drawing it take no handing over of the lock
+ * or waking of another thread. Return only if the event loop couldn't be started.
+ */
+static void reactor_start(tedata_t *t)
+{
+	editor_loop_t l = { .t = t, .timer_armed = false };
+	reactor_t r;
+	sigset_t set;
+	int sigfd;
+
+	handled_sigset(&set);
+	if ((sigfd = signalfd(-1, &set, SFD_CLOEXEC | SFD_NONBLOCK)) == -1 ||
+	    (l.timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)) == -1 ||
+	    !reactor_init(&r)) {
+		tlog("failed to start event loop: %s", strerror(errno));
+		return;
+	}
+	// With a single thread there's no one to hand the lock over to while waiting.
+	t->bufs.lock = NULL;
+	reactor_watch(&r, STDIN_FILENO, (reactor_fn)on_tty, &l);
+	reactor_watch(&r, redraw_fd(), (reactor_fn)on_redraw, &l);
+	reactor_watch(&r, l.timerfd, (reactor_fn)on_timer, &l);
+	reactor_watch(&r, sigfd, (reactor_fn)on_signal, &l);
+	reactor_run(&r);
+	reactor_free(&r);
+}
+#else
+/*
+ * Start the user input main loop. Each loop waits for a key from the user, then handles it
+ * along with any keys read after it by having them affect the current file buffer, and
+ * publishes what the display is to draw of them.
  */
 static void input_start(tedata_t *t)
 {
+	struct timespec read_at;
 	int c;
-	fbuf_t *f;
 
 	for (;;) {
 		c = mygetch();
+		clock_gettime(CLOCK_MONOTONIC, &read_at);
 
 		sem_wait(&t->sem);
-
-		f = t->bufs.active_buf;
-		if (f == t->bufs.active_fbuf)
-			fbinp_handle_char(&t->bufs, c);
-		else 
-			elinp_handle_char(&t->bufs, c, &t->cmds, t->win);
-		view_sync_cursor(&f->view, &f->cursor, &f->lines);
-
+		handle_keys(t, c, &read_at);
+		display_publish(t);
 		sem_post(&t->sem);
+		redraw_request();
 	}
 }
 
+/*
+ * Start the display main loop. Each loop waits for a redraw to be requested and then
+ * displays the text editor, so nothing is drawn while the text editor is idle. Frames are
+ * drawn from the snapshots published, without the lock, so keys are handled meanwhile.
+ */
 static void display_start(tedata_t *t)
 {
+	struct timespec last = { 0 }, now;
+	long since_last;
+
 	for (;;) {
-		sem_wait(&t->sem);
+		redraw_wait();
+
+		// A request straight after the last frame, as in a burst of keys such as a paste,
+		// waits out the rest of the refresh period so that the burst is drawn in one frame.
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		since_last = usec_between(&last, &now);
+		if (since_last < REFRESH_RATE_USE_USEC)
+			usleep(REFRESH_RATE_USE_USEC-since_last);
+		redraw_drain();
+
+		// Published again for what changed other than by a key, such as highlighting
+		// finishing, unless a key is being handled, which publishes once it is.
+		if (!sem_trywait(&t->sem)) {
+			display_publish(t);
+			sem_post(&t->sem);
+		}
 		display_text_editor(t);
-		sem_post(&t->sem);
+		istats_drawn();
+		clock_gettime(CLOCK_MONOTONIC, &last);
+	}
+}
 
-		// To improve performance (lessen CPU usage) use a lower refresh rate.
-		// The tradeoff here is that the display won't be as smooth.
-		usleep(REFRESH_RATE_USE_USEC);
+/*
+ * Resize curses with the lock on the text editor data held, as taking a snapshot reads the
+ * size of the display window, and the lock on drawing, so a frame isn't drawn meanwhile.
+ */
+static void resize_curses_locked(tedata_t *t)
+{
+	sem_wait(&t->sem);
+	sem_wait(&t->draw_sem);
+	resize_curses();
+	sem_post(&t->draw_sem);
+	sem_post(&t->sem);
+}
+
+/*
+ * Start the signal loop, taking the signals handled one at a time. The display draws without
+ * the lock on the text editor data, so the lock on drawing is held from leaving curses to stop
+ * until returning to it, and exiting waits on it too (see tedata_free()), so that neither
+ * happens in the middle of a frame.
+ */
+static void signal_start(tedata_t *t)
+{
+	bool stopped = false;
+	sigset_t set;
+	int sig;
+
+	handled_sigset(&set);
+	for (;;) {
+		if (sigwait(&set, &sig))
+			continue;
+		switch (sig) {
+		case SIGWINCH:
+			// Resized on continuing instead, as the lock on drawing is held until then.
+			if (!stopped)
+				resize_curses_locked(t);
+			break;
+		case SIGTERM:
+			if (stopped)
+				sem_post(&t->draw_sem);
+			exit(EXIT_SUCCESS);
+		case SIGTSTP:
+			sem_wait(&t->draw_sem);
+			sig_leave_curses();
+			stopped = true;
+			// Stopping can't be blocked, unlike SIGTSTP, so is used to stop. Execution
+			// carries on from here on returning to the foreground, with SIGCONT to take.
+			raise(SIGSTOP);
+			break;
+		case SIGCONT:
+			if (!stopped)
+				break;
+			sig_return_to_curses();
+			stopped = false;
+			sem_post(&t->draw_sem);
+			// The terminal may have been resized while stopped.
+			resize_curses_locked(t);
+			break;
+		}
 	}
 }
+#endif
 
 /*
  * cleanup - Free the global text editor data.
@@ -59,15 +341,23 @@ static void display_start(tedata_t *t)
 void cleanup(void)
 {
 	tedata_free(&t);
+	display_free();
 }
 
 int main(int argc, char *argv[])
 {
-	pthread_t tids[2];
+	sigset_t set;
+#ifndef TEDIT_REACTOR
+	pthread_t tids[3];
+#endif
 
 	// Interrupt is ignored entirely and termination ignored while initialising data.
 	signal(SIGINT, SIG_IGN);
 	signal(SIGTERM, SIG_IGN);
+	// Blocked before any threads are started so that they inherit the mask, leaving the
+	// signals to be taken by the event loop or signal thread once the data is initialised.
+	handled_sigset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
 
 	if (!tedata_init(&t, argv+1)) {
 		tlog("failed to init text editor data");
@@ -75,19 +365,20 @@ int main(int argc, char *argv[])
 	}
 
 	atexit(cleanup);
-	signal(SIGTERM, sig_clean_exit);
-	// Use own sigcont and sigtstp handlers for job control as the default curses
-	// implementations jumble the screen on returning to the foreground by its use of
-	// the doupdate function.
-	signal(SIGTSTP, sig_handle_tstp);
-	signal(SIGCONT, sig_handle_cont);
-
+	// An ignored signal is thrown away rather than left pending, so is restored to be taken.
+	signal(SIGTERM, SIG_DFL);
+#ifdef TEDIT_REACTOR
+	reactor_start(&t);
+	return EXIT_FAILURE;
+#else
 	// Below is expected to be exited by the user running a quit command or
 	// receiving a kill/termination signal.
 	pthread_create(&tids[0], NULL, (void *(*)(void *))input_start, (void *)&t);
 	pthread_create(&tids[1], NULL, (void *(*)(void *))display_start, (void *)&t);
+	pthread_create(&tids[2], NULL, (void *(*)(void *))signal_start, (void *)&t);
 
-	pthread_join(tids[0], NULL);
-	pthread_join(tids[1], NULL);
+	for (int i = 0; i < ARRAY_LEN(tids); ++i)
+		pthread_join(tids[i], NULL);
 	return 0;
+#endif
 }
@@ -0,0 +1,170 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "mcursor.h"
+
+/*
+ * Compare cursors by row then column.
+ */
+static int cursor_cmp(cursor_t *c1, cursor_t *c2)
+{
+	if (c1->row != c2->row)
+		return c1->row - c2->row;
+	return c1->col - c2->col;
+}
+
+static int cursorp_cmp(cursor_t **c1, cursor_t **c2)
+{
+	return cursor_cmp(*c1, *c2);
+}
+
+static bool cursor_eq(cursor_t *c1, cursor_t *c2)
+{
+	return cursor_cmp(c1, c2) == 0;
+}
+
+/*
+ * Get an upper bound on the length of a line after an edit at ncrss cursors, so that
+ * it can be rebuilt without growing.
+ */
+static int edited_len_bound(line_t *l, int ncrss, int tabsz)
+{
+	int len = ncrss;  // Room for an inserted character at each cursor.
+	int ntabs = ncrss;  // Any of which could be a tab.
+
+	for (int i = 0; i < l->len; ++i) {
+		if (l->array[i] == TAB_START)
+			++ntabs;
+		else if (l->array[i] != TAB_CONT)
+			++len;
+	}
+	return len+ntabs*tabsz;
+}
+
+/*
+ * Write a character to a column of a line being rebuilt. A tab is written as pseudo spaces
+ * filling up to the next tabstop. Return the column after the character.
+ */
+static int put_char(char *dest, int col, char c, int tabsz)
+{
+	int spaces;
+
+	if (c == '\t' || c == TAB_START) {
+		spaces = dist_to_next_tabstop(col, tabsz);
+		dest[col++] = TAB_START;
+		while (--spaces)
+			dest[col++] = TAB_CONT;
+	} else
+		dest[col++] = c;
+	return col;
+}
+
+/*
+ * Remove the character before a column of a line being rebuilt, the whole of it if it's
+ * a tab. Return the column the character started at.
+ */
+static int unput_char(char *dest, int col)
+{
+	if (col > 0 && dest[--col] == TAB_CONT) {
+		while (dest[col] != TAB_START)
+			--col;
+	}
+	return col;
+}
+
+/*
+ * Get the index one past a character in a line, skipping over the whole of it if it's a tab.
+ */
+static int skip_char(line_t *l, int i)
+{
+	if (l->array[i++] == TAB_START) {
+		while (i < l->len && l->array[i] == TAB_CONT)
+			++i;
+	}
+	return i;
+}
+
+void mcursor_edit_line(line_t *l, cursor_t **crss, int ncrss, enum mcursor_op op, char c, int tabsz)
+{
+	line_t out;
+	int r, w, k, skip_to;
+	char *dest;
+
+	str_alloc(&out, edited_len_bound(l, ncrss, tabsz));
+	dest = out.array;
+	w = k = skip_to = 0;
+
+	for (r = 0; r <= l->len; ++r) {
+		// Apply the edit of each cursor as its column is reached in the original line.
+		for (; k < ncrss && crss[k]->col == r; ++k) {
+			if (op == MCURSOR_INSERT)
+				w = put_char(dest, w, c, tabsz);
+			else if (op == MCURSOR_BACKSPACE)
+				w = unput_char(dest, w);
+			else if (r < line_len(l))
+				skip_to = skip_char(l, r);
+			cursor_set_col_manual(crss[k], w);
+		}
+		if (r == l->len)
+			break;
+		// Copy the original character, dropping a tab's continuation characters so that
+		// the tab gets regrown from its start and realigned.
+		if (r >= skip_to && l->array[r] != TAB_CONT)
+			w = put_char(dest, w, l->array[r], tabsz);
+	}
+	out.len = w;
+	line_free(l);
+	*l = out;
+}
+
+void mcursor_edit(lines_t *ls, cursor_t *primary, dlist_t *extras, enum mcursor_op op, char c,
+		  int tabsz)
+{
+	int i, j, n = extras->len+1;
+	cursor_t **crss = malloc(n*sizeof(cursor_t *));
+
+	crss[0] = primary;
+	for (i = 1; i < n; ++i)
+		crss[i] = dlist_get_address(extras, i-1);
+	qsort(crss, n, sizeof(cursor_t *), (int (*)(const void *, const void *))cursorp_cmp);
+
+	// Edit each run of cursors on the same row together.
+	for (i = 0; i < n; i = j) {
+		for (j = i+1; j < n && crss[j]->row == crss[i]->row; ++j)
+			;
+		mcursor_edit_line(dlist_get_address(ls, crss[i]->row), crss+i, j-i, op, c, tabsz);
+	}
+	free(crss);
+	// Backspacing can bring cursors together.
+	mcursor_normalise(primary, extras);
+}
+
+void mcursor_normalise(cursor_t *primary, dlist_t *extras)
+{
+	cursor_t *cur, *prev = NULL;
+	int w = 0;
+
+	qsort(extras->array, extras->len, sizeof(cursor_t), (int (*)(const void *, const void *))cursor_cmp);
+
+	for (int r = 0; r < extras->len; ++r) {
+		cur = dlist_get_address(extras, r);
+		if (cursor_eq(cur, primary) || (prev && cursor_eq(cur, prev)))
+			continue;
+		dlist_set(extras, w, cur);
+		prev = dlist_get_address(extras, w++);
+	}
+	dlist_resize_len(extras, w);
+}
+
+static bool cursor_at(cursor_t *c, cursor_t *pos)
+{
+	return cursor_eq(c, pos);
+}
+
+bool mcursor_exists(cursor_t *primary, dlist_t *extras, int row, int col)
+{
+	cursor_t c = { row, col };
+	return cursor_eq(primary, &c) || dlist_lookup_address(extras, &c, (dlist_match_fn)cursor_at);
+}
@@ -0,0 +1,67 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Multiple cursors over a list of lines. An edit is applied at every cursor
+ * on a line in a single pass over that line, with the columns of the cursors
+ * updated as the line is rebuilt.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef MCURSOR_H
+#define MCURSOR_H
+
+#include "ds/dlist.h"
+#include "cursor.h"
+#include "lines.h"
+#include "tab.h"
+
+/*
+ * Edit applied at each cursor.
+ * @MCURSOR_INSERT: insert a character before the cursor, moving the cursor past it
+ * @MCURSOR_DELETE: delete the character under the cursor, unless it's a newline
+ * @MCURSOR_BACKSPACE: delete the character before the cursor, unless the cursor is at
+ *	the start of its line
+ */
+enum mcursor_op {
+	MCURSOR_INSERT,
+	MCURSOR_DELETE,
+	MCURSOR_BACKSPACE
+};
+
+/*
+ * mcursor_edit_line - Apply an edit at several cursors on a line in a single pass over the line
+ * @crss: cursors on the line in ascending order of column, with no two cursors on the same
+ *	column. Their columns are set to where the edit leaves them.
+ * @ncrss: number of cursors in crss
+ * @c: character to insert (a regular character or tab) for MCURSOR_INSERT, otherwise ignored
+ *
+ * The line is rebuilt with a single allocation and its tabs realigned as it's copied.
+ * O(n+m*tabsz) worst case time complexity where n is the length of the line and m is the
+ * number of cursors.
+ */
+void mcursor_edit_line(line_t *l, cursor_t **crss, int ncrss, enum mcursor_op op, char c, int tabsz);
+
+/*
+ * mcursor_edit - Apply an edit at a primary cursor and a list of extra cursors
+ * @ls: lines the cursors are over
+ * @extras: list of cursor_t besides the primary cursor
+ *
+ * Cursors are grouped by row so that each affected line is only passed over once.
+ * See mcursor_edit_line() for the other params. Edits don't cross lines, so rows
+ * are unaffected.
+ */
+void mcursor_edit(lines_t *ls, cursor_t *primary, dlist_t *extras, enum mcursor_op op, char c,
+		  int tabsz);
+
+/*
+ * mcursor_normalise - Sort a list of extra cursors by position and remove any that share a
+ *	position with the primary cursor or another extra cursor
+ */
+void mcursor_normalise(cursor_t *primary, dlist_t *extras);
+
+/*
+ * mcursor_exists - Get whether the primary cursor or an extra cursor is at a position
+ */
+bool mcursor_exists(cursor_t *primary, dlist_t *extras, int row, int col);
+
+#endif
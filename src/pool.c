@@ -0,0 +1,117 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "pool.h"
+
+/*
+ * Take the next job off the queue of a pool, waiting for one to be queued.
+ * Requires the pool lock to be held.
+ *
+ * Return false if the pool is stopping instead.
+ */
+static bool take_job(pool_t *p, pool_job_t *out_job)
+{
+	while (p->next_job == p->jobs.len && !p->stop)
+		pthread_cond_wait(&p->queued, &p->lock);
+	if (p->next_job == p->jobs.len)
+		return false;
+	dlist_get(&p->jobs, p->next_job++, out_job);
+	// Reuse the queue from the start once it's been emptied.
+	if (p->next_job == p->jobs.len) {
+		p->next_job = 0;
+		dlist_resize_len(&p->jobs, 0);
+	}
+	return true;
+}
+
+static void *worker_start(pool_t *p)
+{
+	pool_job_t job;
+
+	pthread_mutex_lock(&p->lock);
+	while (take_job(p, &job)) {
+		pthread_mutex_unlock(&p->lock);
+		job.fn(job.arg);
+		pthread_mutex_lock(&p->lock);
+		if (--p->unfinished == 0)
+			pthread_cond_broadcast(&p->done);
+	}
+	pthread_mutex_unlock(&p->lock);
+	return NULL;
+}
+
+void pool_init(pool_t *p, int nworkers)
+{
+	p->nworkers = nworkers;
+	p->workers = malloc(nworkers*sizeof(pthread_t));
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->queued, NULL);
+	pthread_cond_init(&p->done, NULL);
+	dlist_init(&p->jobs, 16, sizeof(pool_job_t));
+	p->next_job = 0;
+	p->unfinished = 0;
+	p->stop = false;
+
+	for (int i = 0; i < nworkers; ++i)
+		pthread_create(p->workers+i, NULL, (void *(*)(void *))worker_start, p);
+}
+
+void pool_free(pool_t *p)
+{
+	pool_wait(p);
+	pthread_mutex_lock(&p->lock);
+	p->stop = true;
+	pthread_cond_broadcast(&p->queued);
+	pthread_mutex_unlock(&p->lock);
+
+	for (int i = 0; i < p->nworkers; ++i)
+		pthread_join(p->workers[i], NULL);
+	free(p->workers);
+	dlist_free(&p->jobs, NULL);
+	pthread_cond_destroy(&p->done);
+	pthread_cond_destroy(&p->queued);
+	pthread_mutex_destroy(&p->lock);
+}
+
+void pool_submit(pool_t *p, pool_job_fn fn, void *arg)
+{
+	pool_job_t job = { fn, arg };
+
+	pthread_mutex_lock(&p->lock);
+	dlist_append(&p->jobs, &job);
+	++p->unfinished;
+	pthread_cond_signal(&p->queued);
+	pthread_mutex_unlock(&p->lock);
+}
+
+void pool_wait(pool_t *p)
+{
+	pthread_mutex_lock(&p->lock);
+	while (p->unfinished)
+		pthread_cond_wait(&p->done, &p->lock);
+	pthread_mutex_unlock(&p->lock);
+}
+
+static pool_t global_pool;
+static pthread_once_t global_pool_once = PTHREAD_ONCE_INIT;
+
+static void global_pool_free(void)
+{
+	pool_free(&global_pool);
+}
+
+static void global_pool_init(void)
+{
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	pool_init(&global_pool, ncpus > 0 ? ncpus : 1);
+	atexit(global_pool_free);
+}
+
+pool_t *pool_global(void)
+{
+	pthread_once(&global_pool_once, global_pool_init);
+	return &global_pool;
+}
@@ -0,0 +1,67 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Pool of worker threads that run jobs taken from a queue. Used to split
+ * work over the lines of a file buffer across CPUs.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "ds/dlist.h"
+
+typedef void (*pool_job_fn)(void *);
+
+typedef struct pool_job {
+	pool_job_fn fn;
+	void *arg;  // Argument fn is called with.
+} pool_job_t;
+
+typedef struct pool {
+	pthread_t *workers;
+	int nworkers;
+	// Lock which must be acquired before accessing the fields below.
+	pthread_mutex_t lock;
+	pthread_cond_t queued;  // Signalled when a job is queued or the pool is stopping.
+	pthread_cond_t done;  // Signalled when there are no more unfinished jobs.
+	dlist_t jobs;  // Queue of pool_job_t.
+	int next_job;  // Index in jobs of the next job to run.
+	int unfinished;  // Number of jobs queued or running.
+	bool stop;  // Whether workers should exit.
+} pool_t;
+
+/*
+ * pool_init - Initialise a pool and start its worker threads
+ * @nworkers: number of worker threads
+ *
+ * Free with pool_free().
+ */
+void pool_init(pool_t *p, int nworkers);
+
+/*
+ * pool_free - Wait for any unfinished jobs, then stop and join the worker threads of a pool
+ */
+void pool_free(pool_t *p);
+
+/*
+ * pool_submit - Queue a job to be run by a worker
+ */
+void pool_submit(pool_t *p, pool_job_fn fn, void *arg);
+
+/*
+ * pool_wait - Wait until every job submitted to a pool has finished
+ */
+void pool_wait(pool_t *p);
+
+/*
+ * pool_global - Get the pool shared by the whole program, with a worker per online CPU
+ *
+ * The pool is started on first use and freed at exit.
+ */
+pool_t *pool_global(void);
+
+#endif
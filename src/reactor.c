@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include "reactor.h"
+#include "log.h"
+
+bool reactor_init(reactor_t *r)
+{
+	if ((r->epfd = epoll_create1(EPOLL_CLOEXEC)) == -1)
+		return false;
+	dlist_init(&r->watches, DLIST_MIN_CAP, sizeof(reactor_watch_t));
+	return true;
+}
+
+void reactor_free(reactor_t *r)
+{
+	dlist_free(&r->watches, NULL);
+	close(r->epfd);
+}
+
+bool reactor_watch(reactor_t *r, int fd, reactor_fn fn, void *arg)
+{
+	reactor_watch_t w = { fd, fn, arg };
+	// Watches are found by index, as their addresses change as the list grows.
+	struct epoll_event ev = { .events = EPOLLIN, .data.u32 = r->watches.len };
+
+	if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, fd, &ev) == -1)
+		return false;
+	dlist_append(&r->watches, &w);
+	return true;
+}
+
+void reactor_run(reactor_t *r)
+{
+	struct epoll_event evs[REACTOR_MAX_EVENTS];
+	reactor_watch_t *w;
+	int n;
+
+	for (;;) {
+		if ((n = epoll_wait(r->epfd, evs, REACTOR_MAX_EVENTS, -1)) == -1) {
+			if (errno == EINTR)
+				continue;
+			tlog("epoll_wait failed: %s", strerror(errno));
+			return;
+		}
+		for (int i = 0; i < n; ++i) {
+			w = dlist_get_address(&r->watches, evs[i].data.u32);
+			w->fn(w->fd, w->arg);
+		}
+	}
+}
@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Event loop dispatching readable file descriptors to handlers, on a single thread, using
+ * epoll. Anything that happens in the background, such as signals (signalfd), timers
+ * (timerfd) or the completion of jobs run by other threads (eventfd, see redraw_fd()), is
+ * watched as a file descriptor, so a handler never runs concurrently with another.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdbool.h>
+#include "ds/dlist.h"
+
+// Most events taken from epoll at once.
+#define REACTOR_MAX_EVENTS 16
+
+/* Handler of a readable file descriptor. */
+typedef void (*reactor_fn)(int fd, void *arg);
+
+typedef struct reactor_watch {
+	int fd;
+	reactor_fn fn;
+	void *arg;  // Argument fn is called with.
+} reactor_watch_t;
+
+typedef struct reactor {
+	int epfd;
+	dlist_t watches;  // reactor_watch_t of each file descriptor watched, by index.
+} reactor_t;
+
+/*
+ * reactor_init - Initialise an event loop without any file descriptors to watch
+ *
+ * Free with reactor_free().
+ * Return whether initialisation was successful.
+ */
+bool reactor_init(reactor_t *r);
+
+/*
+ * reactor_free - Free an event loop
+ *
+ * The file descriptors it watches are left open.
+ */
+void reactor_free(reactor_t *r);
+
+/*
+ * reactor_watch - Watch a file descriptor, calling a handler whenever it's readable
+ * @fn: handler, which must read what's readable or the handler is called again straight away
+ *
+ * Return whether the file descriptor is watched.
+ */
+bool reactor_watch(reactor_t *r, int fd, reactor_fn fn, void *arg);
+
+/*
+ * reactor_run - Wait for file descriptors to become readable and call their handlers,
+ *	forever
+ *
+ * Only returns if waiting fails.
+ */
+void reactor_run(reactor_t *r);
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "redraw.h"
+
+// Counter of pending redraw requests. An eventfd as write() is async-signal-safe, and so that
+// requests can be waited on along with other file descriptors.
+static int pending = -1;
+
+bool redraw_init(void)
+{
+	if ((pending = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1)
+		return false;
+	redraw_request();  // Draw the screen for the first time.
+	return true;
+}
+
+void redraw_free(void)
+{
+	close(pending);
+}
+
+void redraw_request(void)
+{
+	uint64_t one = 1;
+
+	// Can only fail if the counter would overflow, when a redraw is requested anyway.
+	if (write(pending, &one, sizeof(one)) == -1)
+		return;
+}
+
+void redraw_wait(void)
+{
+	struct pollfd p = { .fd = pending, .events = POLLIN };
+
+	// Interrupted by signal handlers such as on returning to the foreground.
+	while (poll(&p, 1, -1) == -1 && errno == EINTR)
+		;
+	redraw_drain();
+}
+
+void redraw_drain(void)
+{
+	uint64_t n;
+
+	// Reading takes every request at once, failing if there are none.
+	if (read(pending, &n, sizeof(n)) == -1)
+		return;
+}
+
+int redraw_fd(void)
+{
+	return pending;
+}
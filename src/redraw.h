@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Requests for the display thread to redraw the screen. The display thread sleeps
+ * until something that changes what's on screen, such as handling a key, a resize taken
+ * by the signal thread (see main.c), returning to the foreground or a background job,
+ * requests a redraw. Built with the event loop (see reactor.h), the requests and resizes
+ * are watched by it instead.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef REDRAW_H
+#define REDRAW_H
+
+#include <stdbool.h>
+
+/*
+ * redraw_init - Initialise redraw requests, with a first redraw requested
+ *
+ * Meant to be called before having started any threads that request redraws.
+ * Return whether initialisation was successful.
+ */
+bool redraw_init(void);
+
+/*
+ * redraw_free - Free redraw requests
+ */
+void redraw_free(void);
+
+/*
+ * redraw_request - Request a redraw of the screen
+ *
+ * Async-signal-safe, so can be called from signal handlers.
+ */
+void redraw_request(void);
+
+/*
+ * redraw_wait - Wait until a redraw has been requested, then take all pending requests
+ *
+ * Call redraw_drain() to take the requests made since.
+ */
+void redraw_wait(void);
+
+/*
+ * redraw_drain - Take all pending redraw requests, since a single redraw handles them all
+ */
+void redraw_drain(void);
+
+/*
+ * redraw_fd - Get a file descriptor that's readable while a redraw is requested, to wait for
+ *	requests along with other events
+ *
+ * Take the requests with redraw_drain().
+ */
+int redraw_fd(void);
+
+#endif
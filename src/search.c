@@ -0,0 +1,146 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "search.h"
+
+void search_init(search_t *s)
+{
+	s->pat = NULL;
+	s->len = 0;
+	s->head_len = 0;
+	tsig_of(NULL, 0, &s->sig);
+}
+
+void search_free(search_t *s)
+{
+	free(s->pat);
+	search_init(s);
+}
+
+void search_set(search_t *s, char *pat, int n)
+{
+	char *tab;
+
+	free(s->pat);
+	s->pat = malloc(n);
+	memcpy(s->pat, pat, n);
+	s->len = n;
+	// Tabs in lines start with TAB_START, so match them by it.
+	for (int i = 0; i < n; ++i) {
+		if (s->pat[i] == '\t')
+			s->pat[i] = TAB_START;
+	}
+	tab = memchr(s->pat, TAB_START, n);
+	s->head_len = tab ? tab-s->pat : n;
+	tsig_of(s->pat, n, &s->sig);
+}
+
+/*
+ * Get whether a pattern matches at an index of a line, a TAB_START in the pattern
+ * matching a whole tab in the line.
+ * @n: length of pat
+ */
+static bool match_at(line_t *l, int i, char *pat, int n)
+{
+	int len = line_len(l);
+
+	for (int j = 0; j < n; ++j) {
+		if (i >= len || l->array[i] != pat[j])
+			return false;
+		for (++i; pat[j] == TAB_START && i < len && l->array[i] == TAB_CONT; ++i)
+			;
+	}
+	return true;
+}
+
+/*
+ * Find the first match in a line starting at a column in [start, end).
+ * Return the column of the match, or -1 if there is none.
+ */
+static int find_in_line(search_t *s, line_t *l, int start, int end)
+{
+	int len = line_len(l);
+	char *p;
+
+	while (start < end) {
+		// Scan for a candidate, a match can run past end.
+		if (s->head_len)
+			p = chrp_memmem(l->array+start, len-start, s->pat, s->head_len);
+		else
+			p = memchr(l->array+start, TAB_START, len-start);
+		if (!p || p-l->array >= end)
+			return -1;
+		start = p-l->array;
+		if (match_at(l, start+s->head_len, s->pat+s->head_len, s->len-s->head_len))
+			return start;
+		++start;
+	}
+	return -1;
+}
+
+/*
+ * Find the last match in a line starting at a column in [start, end).
+ * Return the column of the match, or -1 if there is none.
+ */
+static int find_last_in_line(search_t *s, line_t *l, int start, int end)
+{
+	int col, last = -1;
+
+	while ((col = find_in_line(s, l, start, end)) != -1) {
+		last = col;
+		start = col+1;
+	}
+	return last;
+}
+
+bool search_next(search_t *s, lines_t *ls, sindex_t *si, int row, int col, int *out_row,
+		 int *out_col)
+{
+	line_t *l;
+	int r, start, end, found;
+
+	if (!s->len)
+		return false;
+	// Last pass (i == ls->len) rechecks the starting row up to and including the starting column.
+	for (int i = 0; i <= ls->len; ++i) {
+		r = (row+i)%ls->len;
+		if (si && !sindex_may_match(si, r, &s->sig))
+			continue;
+		l = dlist_get_address(ls, r);
+		start = i == 0 ? col+1 : 0;
+		end = i == ls->len ? col+1 : line_len(l);
+		if ((found = find_in_line(s, l, start, end)) != -1) {
+			*out_row = r;
+			*out_col = found;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool search_prev(search_t *s, lines_t *ls, sindex_t *si, int row, int col, int *out_row,
+		 int *out_col)
+{
+	line_t *l;
+	int r, start, end, found;
+
+	if (!s->len)
+		return false;
+	// Last pass (i == ls->len) rechecks the starting row from the starting column.
+	for (int i = 0; i <= ls->len; ++i) {
+		r = (row-i%ls->len+ls->len)%ls->len;
+		if (si && !sindex_may_match(si, r, &s->sig))
+			continue;
+		l = dlist_get_address(ls, r);
+		start = i == ls->len ? col : 0;
+		end = i == 0 ? col : line_len(l);
+		if ((found = find_last_in_line(s, l, start, end)) != -1) {
+			*out_row = r;
+			*out_col = found;
+			return true;
+		}
+	}
+	return false;
+}
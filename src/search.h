@@ -0,0 +1,71 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Searching for a string in lines. Lines store tabs as pseudo spaces (see tab.h),
+ * so a tab in the string searched for matches a tab of any width in the lines.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+#include "chrp.h"
+#include "lines.h"
+#include "tab.h"
+#include "sindex.h"
+
+/*
+ * The string last searched for, kept so that a search can be repeated.
+ */
+typedef struct search {
+	char *pat;  // String searched for with tabs as TAB_START, NULL if there is none.
+	int len;  // Length of pat.
+	// Length of the prefix of pat before its first tab, which is scanned for with
+	// chrp_memmem() to find candidate matches.
+	int head_len;
+	tsig_t sig;  // Trigram signature of pat, for skipping lines with a search index.
+} search_t;
+
+/*
+ * search_init - Initialise a search without a string to search for
+ */
+void search_init(search_t *s);
+
+/*
+ * search_free - Free a search
+ */
+void search_free(search_t *s);
+
+/*
+ * search_set - Set the string to search for
+ * @pat: string to search for, not necessarily null-terminated
+ * @n: length of pat
+ */
+void search_set(search_t *s, char *pat, int n);
+
+/*
+ * search_next - Find the next match after a position in lines, wrapping around to the
+ *	start of the lines
+ * @si: search index of the lines to skip lines that can't match, or NULL to search every line
+ * @row: row of the position
+ * @col: column of the position
+ * @out_row: out-param row of the match
+ * @out_col: out-param column of the match
+ *
+ * A match at the position itself is only found after wrapping all the way around.
+ * Return whether a match was found.
+ */
+bool search_next(search_t *s, lines_t *ls, sindex_t *si, int row, int col, int *out_row,
+		 int *out_col);
+
+/*
+ * search_prev - Find the previous match before a position in lines, wrapping around to
+ *	the end of the lines
+ *
+ * See search_next() for params.
+ */
+bool search_prev(search_t *s, lines_t *ls, sindex_t *si, int row, int col, int *out_row,
+		 int *out_col);
+
+#endif
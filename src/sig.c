@@ -4,32 +4,24 @@
  * Copyright (C) 2021 Petar Turukalo
  */
 #include "sig.h"
+#include "redraw.h"
+#include "getch.h"
 
-void sig_clean_exit(int sig)
+void sig_leave_curses(void)
 {
-	exit(EXIT_SUCCESS);
-}
-
-void sig_handle_tstp(int sig)
-{
-	// Prepare for returning back to shell.
+	getch_set_paste(false);
 	reset_shell_mode();
 	endwin();
-	
-	// Put program in background.
-	signal(SIGTSTP, SIG_DFL);
-	kill(getpid(), SIGTSTP); 
-	// (Execution continues in the SIGCONT handler on return to foreground.)
 }
 
-void sig_handle_cont(int sig)
+void sig_return_to_curses(void)
 {
-	// Return back to program.
 	// Setup curses again since if this isn't called an escape sequence key such as 
 	// an arrow key is interpreted as the escape key if it's the first key pressed back
 	// on returning to the program.
 	setup_curses();
 	reset_prog_mode();
 	flushinp();
-	signal(SIGTSTP, sig_handle_tstp);
+	// The screen was left to the shell so draw it again.
+	redraw_request();
 }
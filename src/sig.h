@@ -15,12 +15,14 @@
 #include "tedata.h"
 
 /*
- * sig_clean_exit - Signal handler to clean up and free all initialised data before
- *	exiting
+ * sig_leave_curses - Leave the screen to the shell, as before stopping for job control
  */
-void sig_clean_exit(int sig);
+void sig_leave_curses(void);
 
-void sig_handle_tstp(int sig);
-void sig_handle_cont(int sig);
+/*
+ * sig_return_to_curses - Take the screen back from the shell, as on continuing after
+ *	having stopped for job control, and request it be redrawn
+ */
+void sig_return_to_curses(void);
 
 #endif
@@ -0,0 +1,192 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <ctype.h>
+#include <string.h>
+#include "sindex.h"
+
+/*
+ * Get the bit (0 to 127) of a signature that a trigram sets.
+ */
+static int trigram_bit(unsigned char a, unsigned char b, unsigned char c)
+{
+	uint32_t h = (a | b << 8 | c << 16)*0x9e3779b1u;
+	return h >> 25;
+}
+
+void tsig_of(char *s, int n, tsig_t *out_sig)
+{
+	unsigned char a = 0, b = 0;
+	int bit, seen = 0;
+
+	out_sig->bits[0] = out_sig->bits[1] = 0;
+
+	for (int i = 0; i < n; ++i) {
+		if (s[i] == TAB_CONT)
+			continue;
+		if (++seen >= 3) {
+			bit = trigram_bit(a, b, s[i]);
+			out_sig->bits[bit >> 6] |= (uint64_t)1 << (bit & 63);
+		}
+		a = b;
+		b = s[i];
+	}
+}
+
+/*
+ * Get the end of a bracket expression of a regex.
+ * @p: start of the bracket expression, its '['
+ *
+ * Return a pointer to after its closing ']'.
+ */
+static char *skip_bracket(char *p)
+{
+	++p;
+	if (*p == '^')
+		++p;
+	if (*p == ']')  // A leading ']' is literal.
+		++p;
+	for (; *p && *p != ']'; ++p) {
+		// Skip character classes such as [:alpha:] whole, since they end in ']'.
+		if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+			char *end = strchr(p+2, p[1]);
+			if (end && end[1] == ']')
+				p = end+1;
+		}
+	}
+	return *p ? p+1 : p;
+}
+
+/*
+ * Get the longest string that every match of an extended regex contains. Only characters
+ * outside any group are considered, and an alternation outside any group rules out every
+ * string, so the string found is always required, though not always the longest one.
+ * @out_lit: out-param string found, with room for at least the length of pat
+ *
+ * Return the length of the string, 0 if none was found.
+ */
+static int required_literal(char *pat, char *out_lit)
+{
+	int best = 0, n = 0, depth = 0;
+	char *run = malloc(strlen(pat)+1);
+	char *p = pat;
+	char c;
+	bool lit;
+
+	while (*p) {
+		lit = false;
+		if (*p == '|' && depth == 0) {
+			free(run);
+			return 0;
+		} else if (*p == '[') {
+			p = skip_bracket(p);
+		} else if (*p == '(' || *p == ')') {
+			depth += *p++ == '(' ? 1 : -1;
+		} else if (*p == '\\' && p[1]) {
+			// An escaped punctuation character is literal, other escapes are classes,
+			// anchors or back references.
+			lit = ispunct(p[1]);
+			c = p[1];
+			p += 2;
+		} else if (*p == '{') {
+			while (*p && *p++ != '}')
+				;
+		} else if (strchr(".^$*+?|", *p)) {
+			++p;
+		} else {
+			lit = true;
+			c = *p++;
+		}
+
+		if (lit && depth == 0 && *p != '*' && *p != '?' && *p != '{') {
+			run[n++] = c;
+			// Repeating a character with + still has it at least once, but ends the run.
+			if (*p != '+')
+				continue;
+		}
+		if (n > best) {
+			best = n;
+			memcpy(out_lit, run, n);
+		}
+		n = 0;
+	}
+	if (n > best) {
+		best = n;
+		memcpy(out_lit, run, n);
+	}
+	free(run);
+	return best;
+}
+
+void tsig_of_regex(char *pat, tsig_t *out_sig)
+{
+	char *lit = malloc(strlen(pat)+1);
+	int n = required_literal(pat, lit);
+
+	// Lines keep tabs as pseudo spaces starting with TAB_START.
+	for (int i = 0; i < n; ++i) {
+		if (lit[i] == '\t')
+			lit[i] = TAB_START;
+	}
+	tsig_of(lit, n, out_sig);
+	free(lit);
+}
+
+bool tsig_empty(tsig_t *sig)
+{
+	return !sig->bits[0] && !sig->bits[1];
+}
+
+sindex_t *sindex_alloc(void)
+{
+	sindex_t *si = malloc(sizeof(sindex_t));
+
+	dlist_init(&si->sigs, DLIST_MIN_CAP, sizeof(tsig_t));
+	return si;
+}
+
+void sindex_free(sindex_t *si)
+{
+	if (si) {
+		dlist_free(&si->sigs, NULL);
+		free(si);
+	}
+}
+
+/*
+ * Set the signature of a row of an index from its line.
+ */
+static void sindex_set(sindex_t *si, lines_t *ls, int row)
+{
+	line_t *l = dlist_get_address(ls, row);
+
+	tsig_of(l->array, line_len(l), dlist_get_address(&si->sigs, row));
+}
+
+void sindex_build(sindex_t *si, lines_t *ls)
+{
+	dlist_free(&si->sigs, NULL);
+	dlist_init(&si->sigs, ls->len, sizeof(tsig_t));
+	si->sigs.len = ls->len;
+
+	for (int row = 0; row < ls->len; ++row)
+		sindex_set(si, ls, row);
+}
+
+void sindex_splice(sindex_t *si, lines_t *ls, int row, int nold, int nnew)
+{
+	// Room for any extra rows is made all at once, set below.
+	dlist_splice_zeroed(&si->sigs, row, nold, nnew);
+	for (int i = 0; i < nnew; ++i)
+		sindex_set(si, ls, row+i);
+}
+
+bool sindex_may_match(sindex_t *si, int row, tsig_t *sig)
+{
+	tsig_t *line_sig = dlist_get_address(&si->sigs, row);
+
+	return (line_sig->bits[0] & sig->bits[0]) == sig->bits[0] &&
+	       (line_sig->bits[1] & sig->bits[1]) == sig->bits[1];
+}
@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Search index of lines. Each line has a signature of the trigrams (runs of three
+ * characters) in it, a 128 bit set with a bit hashed from each trigram. A line can
+ * only contain a string if its signature has every bit of the string's signature,
+ * so searches can skip lines without looking at their text.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef SINDEX_H
+#define SINDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lines.h"
+#include "tab.h"
+
+// Fewest lines a file buffer has before it's worth indexing.
+#define SINDEX_MIN_LINES 8192
+
+typedef struct tsig {
+	uint64_t bits[2];
+} tsig_t;
+
+typedef struct sindex {
+	dlist_t sigs;  // Signature (tsig_t) of each line, in the same order as the lines.
+} sindex_t;
+
+/*
+ * tsig_of - Get the trigram signature of characters, with tabs as pseudo spaces
+ * @n: number of characters in s
+ *
+ * The TAB_CONT of a tab are skipped so that a tab is a single TAB_START character.
+ * O(n) worst case time complexity.
+ */
+void tsig_of(char *s, int n, tsig_t *out_sig);
+
+/*
+ * tsig_of_regex - Get the trigram signature of a string every match of a POSIX extended
+ *	regex contains, with tabs as pseudo spaces
+ *
+ * The signature is empty if no such string could be found.
+ */
+void tsig_of_regex(char *pat, tsig_t *out_sig);
+
+/*
+ * tsig_empty - Get whether a signature has no trigrams, such as that of a string shorter than
+ *	three characters, so an index can't rule out any line for it
+ */
+bool tsig_empty(tsig_t *sig);
+
+/*
+ * sindex_alloc - Allocate an empty index, to be built with sindex_build()
+ *
+ * Free with sindex_free().
+ */
+sindex_t *sindex_alloc(void);
+
+/*
+ * sindex_free - Free an index, if there is one
+ */
+void sindex_free(sindex_t *si);
+
+/*
+ * sindex_build - Build the index of lines
+ *
+ * O(n) worst case time complexity where n is the total length of the lines.
+ */
+void sindex_build(sindex_t *si, lines_t *ls);
+
+/*
+ * sindex_splice - Update an index after rows of its lines have been replaced
+ * @ls: lines after the edit
+ * @row: first row replaced
+ * @nold: number of rows replaced
+ * @nnew: number of rows that replaced them
+ *
+ * Only the signatures of the nnew rows are recomputed.
+ */
+void sindex_splice(sindex_t *si, lines_t *ls, int row, int nold, int nnew);
+
+/*
+ * sindex_may_match - Get whether a line could contain a string with a signature
+ */
+bool sindex_may_match(sindex_t *si, int row, tsig_t *sig);
+
+#endif
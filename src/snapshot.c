@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <stdlib.h>
+#include "snapshot.h"
+
+static void row_init(snapshot_row_t *r)
+{
+	dlist_init(&r->chars, DLIST_MIN_CAP, sizeof(char));
+	dlist_init(&r->spans, DLIST_MIN_CAP, sizeof(regmatch_data_t));
+	dlist_init(&r->cursor_cols, DLIST_MIN_CAP, sizeof(int));
+}
+
+static void row_free(snapshot_row_t *r)
+{
+	dlist_free(&r->chars, NULL);
+	dlist_free(&r->spans, NULL);
+	dlist_free(&r->cursor_cols, NULL);
+}
+
+static void pane_free(snapshot_pane_t *p)
+{
+	dlist_free(&p->rows, (dlist_elem_fn)row_free);
+}
+
+static snapshot_t *snapshot_alloc(void)
+{
+	snapshot_t *snap = malloc(sizeof(snapshot_t));
+
+	dlist_init(&snap->fbuf.rows, DLIST_MIN_CAP, sizeof(snapshot_row_t));
+	dlist_init(&snap->elbuf.rows, DLIST_MIN_CAP, sizeof(snapshot_row_t));
+	return snap;
+}
+
+static void snapshot_free(snapshot_t *snap)
+{
+	pane_free(&snap->fbuf);
+	pane_free(&snap->elbuf);
+	free(snap);
+}
+
+/*
+ * Take the view of a buffer in a pane: the columns in view of each line on it, the extra
+ * cursors on them and, with a colour map, their spans. The rows of a reused pane keep their
+ * lists, so a row only allocates when its line is longer than any it had before.
+ * @c: colour map painted for the buffer, NULL without colours
+ * @versioned: whether the buffer keeps the versions of its lines
+ */
+static void take_pane(snapshot_pane_t *p, fbuf_t *f, clrmap_t *c, bool versioned)
+{
+	view_t *v = &f->view;
+	int height = view_height(v);
+	int bot_row = view_lines_bot_row(v, &f->lines);
+	snapshot_row_t *r;
+	line_t *l;
+	cursor_t *crs;
+	int lnr, n, col;
+
+	p->top_y = view_display_top_row(v);
+	p->x = view_display_first_col(v);
+	p->width = view_width(v);
+	p->first_col = v->lines_first_col;
+	if (p->rows.len > height)
+		dlist_delete_range(&p->rows, height, p->rows.len-height, (dlist_elem_fn)row_free);
+	while (p->rows.len < height)
+		dlist_append_init(&p->rows, (dlist_elem_fn)row_init);
+
+	for (int i = 0; i < height; ++i) {
+		r = dlist_get_address(&p->rows, i);
+		lnr = v->lines_top_row+i;
+		dlist_resize_len(&r->chars, 0);
+		dlist_resize_len(&r->spans, 0);
+		dlist_resize_len(&r->cursor_cols, 0);
+		r->version = 0;
+		if (lnr > bot_row)
+			continue;
+		if (versioned)
+			r->version = fbuf_line_version(f, lnr);
+		l = dlist_get_address(&f->lines, lnr);
+		n = line_len(l)-p->first_col;
+		if (n > p->width)
+			n = p->width;
+		if (n > 0)
+			dlist_copy_array(&r->chars, l->array+p->first_col, n, NULL);
+		if (c)
+			dlist_copy(&r->spans, clrmap_row_spans(c, p->top_y+i), NULL);
+	}
+
+	for (int i = 0; i < f->cursors.len; ++i) {
+		crs = dlist_get_address(&f->cursors, i);
+		if (crs->row < v->lines_top_row || crs->row > bot_row || !col_in_view(v, crs->col))
+			continue;
+		r = dlist_get_address(&p->rows, crs->row-v->lines_top_row);
+		col = view_cursor_display_col(v, crs)-p->x;
+		dlist_append(&r->cursor_cols, &col);
+	}
+}
+
+void snapshots_init(snapshots_t *s)
+{
+	atomic_init(&s->published, NULL);
+	epoch_init(&s->epoch);
+}
+
+void snapshots_free(snapshots_t *s)
+{
+	snapshot_t *snap = atomic_load(&s->published);
+
+	if (snap)
+		snapshot_free(snap);
+	epoch_free(&s->epoch, (dlist_elem_fn)snapshot_free);
+}
+
+void snapshots_publish(snapshots_t *s, bufs_t *b, clrmap_t *c)
+{
+	snapshot_t *snap = epoch_reclaim(&s->epoch), *old;
+	fbuf_t *active = b->active_buf;
+
+	// More than one is retired while the display is drawing, so those beyond the one reused
+	// are freed rather than left to pile up.
+	while ((old = epoch_reclaim(&s->epoch)))
+		snapshot_free(old);
+	if (!snap)
+		snap = snapshot_alloc();
+	if (c)
+		clrmap_syntax_highlight(c, b->active_fbuf);
+	take_pane(&snap->fbuf, b->active_fbuf, c, true);
+	take_pane(&snap->elbuf, &b->elbuf, NULL, false);
+	snap->coloured = c;
+	snap->cursor_y = view_cursor_display_row(&active->view, &active->cursor);
+	snap->cursor_x = view_cursor_display_col(&active->view, &active->cursor);
+
+	// Retired only once it's replaced, see epoch.h.
+	if ((old = atomic_exchange(&s->published, snap)))
+		epoch_retire(&s->epoch, old);
+}
+
+snapshot_t *snapshots_enter(snapshots_t *s)
+{
+	epoch_enter(&s->epoch);
+	return atomic_load(&s->published);
+}
+
+void snapshots_leave(snapshots_t *s)
+{
+	epoch_leave(&s->epoch);
+}
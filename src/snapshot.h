@@ -0,0 +1,89 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Snapshots of what the display shows of the buffers: the text in view, cursors and colours.
+ * A snapshot is taken and published while handling keys, with the lock on the text editor data
+ * held, and drawn by the display without the lock, so that neither waits on the other for
+ * anything but the taking of a snapshot. A snapshot is never changed once published, and is
+ * only reused once the display is done with it (see epoch.h).
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "epoch.h"
+#include "fbuf/bufs.h"
+#include "synhl/clrmap.h"
+
+typedef struct snapshot_row {
+	unsigned long version;  // Version of the line on the row (see fbuf struct), 0 for none.
+	dlist_t chars;  // Characters (char) of the line in view.
+	dlist_t spans;  // Spans (regmatch_data_t) to colour, see clrmap_t.
+	dlist_t cursor_cols;  // Columns (int) of the pane with extra cursors on them.
+} snapshot_row_t;
+
+/*
+ * Rows of the curses window showing the view of a buffer.
+ */
+typedef struct snapshot_pane {
+	int top_y;  // Row of the window the first row is displayed on.
+	int x;  // Column of the window the rows start at.
+	int width;  // Columns of the lines in view.
+	int first_col;  // Column of the lines in view first.
+	dlist_t rows;  // snapshot_row_t of each row of the view.
+} snapshot_pane_t;
+
+typedef struct snapshot {
+	snapshot_pane_t fbuf;  // Active file buffer.
+	snapshot_pane_t elbuf;  // Echo line buffer, whose lines aren't versioned.
+	bool coloured;  // Whether the file buffer rows are coloured with their spans.
+	// Position in the window of the cursor of the active buffer.
+	int cursor_y;
+	int cursor_x;
+} snapshot_t;
+
+typedef struct snapshots {
+	_Atomic(snapshot_t *) published;  // Latest snapshot, NULL until one is published.
+	epoch_t epoch;  // Snapshots replaced, reused once the display is done with them.
+} snapshots_t;
+
+/*
+ * snapshots_init - Initialise snapshots without any published
+ *
+ * Free with snapshots_free().
+ */
+void snapshots_init(snapshots_t *s);
+
+/*
+ * snapshots_free - Free snapshots once the display is done with them
+ */
+void snapshots_free(snapshots_t *s);
+
+/*
+ * snapshots_publish - Take a snapshot of what the display shows of buffers and publish it
+ * @c: colour map to paint with syntax highlighting for the snapshot, NULL without colours
+ *
+ * A snapshot the display is done with is reused, so that publishing takes no allocation, and
+ * any others it's done with are freed.
+ * Requires the lock on the text editor data to be held.
+ */
+void snapshots_publish(snapshots_t *s, bufs_t *b, clrmap_t *c);
+
+/*
+ * snapshots_enter - Get the latest snapshot published, for the display to draw
+ *
+ * The snapshot isn't reused until snapshots_leave(). There's only one display, so only one
+ * thread enters at once.
+ * Return the snapshot, NULL if none has been published.
+ */
+snapshot_t *snapshots_enter(snapshots_t *s);
+
+/*
+ * snapshots_leave - Be done with the snapshot entered
+ */
+void snapshots_leave(snapshots_t *s);
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <ctype.h>
+#include "subst.h"
+
+// Fewest lines worth handing to a worker, below which the pool isn't used.
+#define SUBST_CHUNK_MIN_LINES 4096
+// Most subexpression matches that can be referred to in a replacement (\0 to \9).
+#define SUBST_NMATCH 10
+
+/*
+ * Terminate the next field of a substitution at its delimiter, removing the backslashes
+ * of any escaped delimiters. Other escapes are kept for the regex or replacement.
+ *
+ * Return a pointer to after the delimiter, or NULL if the field runs to the end of the string.
+ */
+static char *split_field(char *s, char delim)
+{
+	char *w = s;
+
+	for (; *s; ++s) {
+		if (*s == '\\' && s[1] == delim) {
+			*w++ = *++s;
+		} else if (*s == '\\' && s[1]) {
+			*w++ = *s++;
+			*w++ = *s;
+		} else if (*s == delim) {
+			*w = '\0';
+			return s+1;
+		} else
+			*w++ = *s;
+	}
+	*w = '\0';
+	return NULL;
+}
+
+bool subst_parse(char *s, subst_t *out_sub, char **out_rest)
+{
+	char delim = *s;
+	char *flags;
+
+	*out_rest = NULL;
+	if (!ispunct(delim) || delim == '\\')
+		return false;
+	out_sub->pat = s+1;
+	if (!(out_sub->rep = split_field(out_sub->pat, delim)) || !*out_sub->pat)
+		return false;
+	out_sub->global = false;
+	// The delimiter after the replacement can be left off if there are no flags.
+	if (!(flags = split_field(out_sub->rep, delim)))
+		return true;
+	for (; *flags == 'g'; ++flags)
+		out_sub->global = true;
+	if (*flags && *flags != ' ')
+		return false;
+	*out_rest = strnchr(flags, ' ');
+	return true;
+}
+
+/*
+ * A chunk of a range of lines to substitute in, run as a pool job.
+ */
+typedef struct subst_job {
+	subst_t *sub;
+	lines_t *ls;
+	int start;  // First row of the chunk (inclusive).
+	int end;  // Last row of the chunk (inclusive).
+	int tabsz;
+	int nsubs;  // Out-param number of matches replaced.
+} subst_job_t;
+
+static void append(str_t *s, char *t, int n)
+{
+	dlist_insert_array(s, s->len, t, n);
+}
+
+/*
+ * Append the replacement for a match.
+ * @s: string matched in
+ * @m: matches of the whole regex and its subexpressions in s
+ */
+static void append_rep(str_t *out, char *rep, char *s, regmatch_t *m)
+{
+	int g;
+
+	for (char *p = rep; *p; ++p) {
+		g = -1;
+		if (*p == '&')
+			g = 0;
+		else if (*p == '\\' && isdigit(p[1]))
+			g = *++p-'0';
+		else if (*p == '\\' && p[1])
+			++p;  // Literal character.
+
+		if (g == -1)
+			append(out, p, 1);
+		else if (m[g].rm_so != -1)
+			append(out, s+m[g].rm_so, m[g].rm_eo-m[g].rm_so);
+	}
+}
+
+/*
+ * Replace a line with a string of its substituted text, expanding the string's tabs into
+ * pseudo spaces. The new line is allocated once at its final length.
+ */
+static void rebuild(line_t *l, str_t *s, int tabsz)
+{
+	bool has_newline = line_len(l) != l->len;
+	line_t nl;
+
+	for (int i = 0; i < s->len; ++i) {
+		if (s->array[i] == '\t')
+			s->array[i] = TAB_START;
+	}
+	str_alloc(&nl, tab_realigned_col(s->array, s->len, 0, tabsz)+1);
+	nl.len = tab_realigned_copy(nl.array, 0, s->array, s->len, tabsz);
+	if (has_newline)
+		nl.array[nl.len++] = '\n';
+	line_free(l);
+	*l = nl;
+}
+
+/*
+ * Substitute in a line.
+ * @in: scratch string for the contracted line
+ * @out: scratch string for the substituted line
+ *
+ * Return the number of matches replaced.
+ */
+static int subst_line(subst_t *sub, regex_t *re, line_t *l, str_t *in, str_t *out, int tabsz)
+{
+	regmatch_t m[SUBST_NMATCH];
+	int off = 0, nsubs = 0;
+	int n;
+
+	line_contract(l, in);
+	n = in->len;
+	out->len = 0;
+
+	for (;;) {
+		// Matched from the offset within the whole line, rather than from a pointer to the
+		// offset, so that anchors such as \< see the characters before it.
+		m[0].rm_so = off;
+		m[0].rm_eo = n;
+		if (off > n || regexec(re, in->array, SUBST_NMATCH, m, REG_STARTEND))
+			break;
+		append(out, in->array+off, m[0].rm_so-off);
+		append_rep(out, sub->rep, in->array, m);
+		++nsubs;
+		if (m[0].rm_so == m[0].rm_eo) {
+			// Step over a character after an empty match so it isn't matched again.
+			if (m[0].rm_eo < n)
+				append(out, in->array+m[0].rm_eo, 1);
+			off = m[0].rm_eo+1;
+		} else
+			off = m[0].rm_eo;
+		if (!sub->global)
+			break;
+	}
+	if (!nsubs)
+		return 0;
+	if (off < n)
+		append(out, in->array+off, n-off);
+	rebuild(l, out, tabsz);
+	return nsubs;
+}
+
+static void subst_job_run(subst_job_t *job)
+{
+	regex_t re;
+	str_t in, out;
+
+	// Each job compiles its own copy of the regex as glibc locks a regex for the duration
+	// of a regexec() call, which would serialise the workers.
+	if (regcomp(&re, job->sub->pat, REG_EXTENDED))
+		return;
+	str_alloc(&in, 256);
+	str_alloc(&out, 256);
+
+	for (int row = job->start; row <= job->end; ++row) {
+		job->nsubs += subst_line(job->sub, &re, dlist_get_address(job->ls, row), &in, &out,
+					 job->tabsz);
+	}
+	line_free(&out);
+	line_free(&in);
+	regfree(&re);
+}
+
+int subst_lines(subst_t *sub, lines_t *ls, int start, int end, int tabsz, char *errbuf,
+		int errbufsz)
+{
+	int err, nlines, njobs, nsubs;
+	subst_job_t *jobs;
+	regex_t re;
+	pool_t *p;
+
+	if ((err = regcomp(&re, sub->pat, REG_EXTENDED))) {
+		regerror(err, &re, errbuf, errbufsz);
+		return -1;
+	}
+	regfree(&re);
+
+	nlines = end-start+1;
+	njobs = (nlines+SUBST_CHUNK_MIN_LINES-1)/SUBST_CHUNK_MIN_LINES;
+	p = njobs > 1 ? pool_global() : NULL;
+	if (p && njobs > p->nworkers)
+		njobs = p->nworkers;
+	jobs = malloc(njobs*sizeof(subst_job_t));
+
+	// Split the range into a chunk per job, spreading the remainder over the first chunks.
+	for (int i = 0; i < njobs; ++i) {
+		jobs[i].sub = sub;
+		jobs[i].ls = ls;
+		jobs[i].start = i == 0 ? start : jobs[i-1].end+1;
+		jobs[i].end = jobs[i].start+nlines/njobs-1+(i < nlines%njobs);
+		jobs[i].tabsz = tabsz;
+		jobs[i].nsubs = 0;
+	}
+	if (p) {
+		for (int i = 0; i < njobs; ++i)
+			pool_submit(p, (pool_job_fn)subst_job_run, jobs+i);
+		pool_wait(p);
+	} else
+		subst_job_run(jobs);
+
+	nsubs = 0;
+	for (int i = 0; i < njobs; ++i)
+		nsubs += jobs[i].nsubs;
+	free(jobs);
+	return nsubs;
+}
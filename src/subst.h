@@ -0,0 +1,52 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Substituting a replacement for the matches of a regex in lines. A range of
+ * lines is split into chunks which are matched and rebuilt by the workers of
+ * the global pool (see pool.h).
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef SUBST_H
+#define SUBST_H
+
+#include <regex.h>
+#include <stdbool.h>
+#include "lines.h"
+#include "pool.h"
+#include "tab.h"
+
+typedef struct subst {
+	char *pat;  // POSIX extended regex pattern, tabs in lines are matched as '\t'.
+	// Replacement for a match, where & is the whole match and \0 to \9 the match of a
+	// subexpression. A backslash makes the character after it literal.
+	char *rep;
+	bool global;  // Whether to replace every match in a line, not only the first.
+} subst_t;
+
+/*
+ * subst_parse - Parse a substitution of format "/pattern/replacement/[g]"
+ * @s: string to parse, which is modified in place and pointed into by sub. The delimiter
+ *	is the first character of s, whatever it is, and can be escaped with a backslash to
+ *	appear in the pattern or replacement.
+ * @out_rest: out-param rest of s after the substitution, with leading spaces skipped, or NULL
+ *	if there's nothing after it
+ *
+ * Return whether s could be parsed.
+ */
+bool subst_parse(char *s, subst_t *out_sub, char **out_rest);
+
+/*
+ * subst_lines - Substitute the replacement for matches of the pattern in a range of lines
+ * @start: first row of the range (inclusive)
+ * @end: last row of the range (inclusive)
+ * @errbuf: out-param error message if the pattern couldn't be compiled
+ * @errbufsz: size of errbuf
+ *
+ * Each line with a match is rebuilt with a single allocation. Lines without a match are left
+ * untouched. Return the number of matches replaced, or -1 if the pattern couldn't be compiled.
+ */
+int subst_lines(subst_t *sub, lines_t *ls, int start, int end, int tabsz, char *errbuf,
+		int errbufsz);
+
+#endif
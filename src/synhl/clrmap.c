@@ -8,221 +8,179 @@
 #include "colour.h"
 #include "../log.h"
 
-/*
- * Number of extra lines above the view to include when syntax highlighting so that 
- * a syntax element such as a multiline comment can be coloured in case its start is
- * above the view, or its end is below the view.
- *
- * If a very long (in height) multiline comment still isn't being coloured then increase this.
- */
-static const int EXTRA_LINES = 63;
+static void row_init(dlist_t *spans)
+{
+	dlist_init(spans, DLIST_MIN_CAP, sizeof(regmatch_data_t));
+}
+
+static void row_free(dlist_t *spans)
+{
+	dlist_free(spans, NULL);
+}
 
 void clrmap_init(clrmap_t *c, WINDOW *w)
 {
-	matrix_init(&c->clrmap, getmaxy(w), getmaxx(w), sizeof(clrpair_t));
+	dlist_init(&c->rows, getmaxy(w), sizeof(dlist_t));
 	c->win = w;
+	hlworker_init(&c->worker);
 }
 
 /*
- * Take a snapshot of the current lines in a file buffer centered around the file buffer's view. 
- * A merged copy of the lines is stored into a single flattened string. Lines in the flat string
- * are delimited by a newline character.
- *
- * Although there is a concept of "extra lines" above and below the view, there is no concept of extra
- * columns to either side of the view because a typical source code file won't have long lines (so including the 
- * full line won't affect performance) but there will be syntax elements that aren't fully in view horizontally 
- * that need to be coloured. 
- *
- * @s: string to store flattened lines in
- * @extra_lines: number of extra lines above the view to include in the snapshot. And the same for
- *	below the view.
+ * Resize the height of the colour map to match the current size of the curses window, and
+ * clear the spans of every row.
  */
-static void take_flat_lines_snapshot(fbuf_t *f, str_t *s, int extra_lines)
+static void clrmap_clear(clrmap_t *c)
 {
-	lines_t *ls = &f->lines;
-	int top_row = lines_add_row(ls, f->view.lines_top_row, -extra_lines);
-	int bot_row = lines_add_row(ls, view_lines_bot_row(&f->view, ls), extra_lines);
-	line_t *l;
-
-	for (int i = top_row; i <= bot_row; ++i) {
-		l = dlist_get_address(&f->lines, i);
-		dlist_cat(s, l);
-	}
-	str_append(s, '\0');
+	int nrows = getmaxy(c->win);
+
+	if (c->rows.len > nrows)
+		dlist_delete_range(&c->rows, nrows, c->rows.len-nrows, (dlist_elem_fn)row_free);
+	while (c->rows.len < nrows)
+		dlist_append_init(&c->rows, (dlist_elem_fn)row_init);
+	for (int i = 0; i < nrows; ++i)
+		dlist_resize_len(dlist_get_address(&c->rows, i), 0);
 }
 
 /*
- * Resize the width and height of the colour map to match the current size of the curses window.
+ * Get the cached highlighting of a line of a file buffer, NULL if it isn't cached for the
+ * rules and the state it starts in. Requires the worker lock to be held.
  */
-static void clrmap_resz(clrmap_t *c)
+static hlline_t *cached_line(clrmap_t *c, fbuf_t *f, int row, file_syntax_rules_t *rules,
+			     hlstate_t state)
 {
-	matrix_resz(&c->clrmap, getmaxy(c->win), getmaxx(c->win));
-}
+	hlline_t *hl = hlworker_get(&c->worker, fbuf_line_version(f, row));
 
-static int regmatch_data_cmp(regmatch_data_t *r1, regmatch_data_t *r2)
-{
-	return r1->start - r2->start;
+	return hl && hl->rules == rules && hl->start_state == state ? hl : NULL;
 }
 
 /*
- * Update a cursor's position to the start of the next line/row.
+ * What the state a row ends in is found with, see cached_end_state().
  */
-static void next_row(cursor_t *c)
-{
-	++c->row;
-	c->col = 0;
-}
+typedef struct cached_end {
+	clrmap_t *c;
+	fbuf_t *f;
+	file_syntax_rules_t *rules;
+} cached_end_t;
 
 /*
- * Update a cursor position to a next cell position dependent on the
- * current character that it is over.
+ * Get the state a row ends in from its cached highlighting, see hlstates_end_fn.
  */
-static void next_cell(cursor_t *crs, char c)
+static bool cached_end_state(int row, int start_state, cached_end_t *e, int *out_state)
 {
-	if (c == '\n') 
-		next_row(crs);
-	else 
-		++crs->col;
-}
+	hlline_t *hl = cached_line(e->c, e->f, row, e->rules, start_state);
 
-/* Bookkeeping data used by clrmap_paint(). */
-struct paint_data {
-	// The cursor positions are kept separate because the set of lines that the colour 
-	// map covers will be a subset of the lines in the flat lines snapshot string, since
-	// the snapshot includes extra lines.
-	cursor_t cpos;  // Current cell position in the colour map.
-	cursor_t spos;  // Current cell position in the lines snapshot string if it weren't flat.
-	matrix_t *clrmap;
-	view_t *v;
-	// The actual amount of extra lines above the view. This can be less than the extra lines passed
-	// to take_flat_lines_snapshot() when the top of the view is close to the top of the lines as
-	// there aren't enough actual extra lines to include.
-	int extra_lines_above;  
-	// Current number of consecutive in-view columns found. Gets reset to 0 whenever an
-	// out-of-view column is found.
-	int nconsec_cols_in_view;  
-};
+	if (hl)
+		*out_state = hl->end_state;
+	return hl;
+}
 
 /*
- * Get whether the current cursor position tracking the string is within the view vertically.
- * If true it could still be out of view horizontally.
+ * Get the state highlighting starts a row of a file buffer in, first finding the states of
+ * the rows before it that aren't known with their cached highlighting. Requires the worker
+ * lock to be held.
+ * @out_state: out-param state of the row
+ *
+ * Return false if the highlighting of a row before it isn't cached, in which case the last
+ * row whose state is known is f->hlstates.known-1.
  */
-static bool spos_in_vertical_view(struct paint_data *p)
+static bool start_state(clrmap_t *c, fbuf_t *f, int row, file_syntax_rules_t *rules,
+			hlstate_t *out_state)
 {
-	int row = p->spos.row;
-	return row >= p->extra_lines_above && row < p->extra_lines_above+view_height(p->v);
+	cached_end_t e = { .c = c, .f = f, .rules = rules };
+
+	if (f->hlrules != rules || f->hlgen != c->worker.rules_gen) {
+		f->hlrules = rules;
+		f->hlgen = c->worker.rules_gen;
+		hlstates_reset(&f->hlstates);
+	}
+	return hlstates_find(&f->hlstates, row, (hlstates_end_fn)cached_end_state, &e, out_state);
 }
 
 /*
- * Get whether the current cursor position tracking the string is in view and
- * over the colour map. 
+ * Get the index of the first span of a line's highlighting that ends after a column.
  */
-static bool spos_in_view(struct paint_data *p)
+static int first_span_after(hlline_t *hl, int col)
 {
-	return spos_in_vertical_view(p) && col_in_view(p->v, p->spos.col);
+	int lo = 0, hi = hl->spans.len, mid;
+	regmatch_data_t *span;
+
+	while (lo < hi) {
+		mid = (lo+hi)/2;
+		span = dlist_get_address(&hl->spans, mid);
+		if (span->end <= col)
+			lo = mid+1;
+		else
+			hi = mid;
+	}
+	return lo;
 }
 
 /*
- * Set the colour at the colour map cursor position if the string cursor is in view. 
- * Update all cursors to their next cell position.
+ * Paint the row of the colour map of a line in view with the spans of its highlighting that
+ * are in view, so that painting a long line costs no more than a short one.
  */
-static void paint(struct paint_data *p, clrpair_t clrpair, char c)
+static void paint_line(clrmap_t *c, view_t *v, int row, hlline_t *hl)
 {
-	if (spos_in_view(p)) {
-		if (clrpair != COLOUR_DEFAULT)
-			matrix_set(p->clrmap, p->cpos.row, p->cpos.col, &clrpair);
-		next_cell(&p->cpos, c);
-		if (c == '\n')
-			// Moved to a next line because found a newline character, so
-			// make sure don't move to a next line when get out of view.
-			p->nconsec_cols_in_view = 0;
-		else
-			++p->nconsec_cols_in_view;
-	} else if (p->nconsec_cols_in_view) {  
-		// If reached here then got out of view but hadn't found a newline: force
-		// colour map cursor onto the next line.
-		next_row(&p->cpos);
-		p->nconsec_cols_in_view = 0;
-	} else if (spos_in_vertical_view(p) && p->spos.col < p->v->lines_first_col && c == '\n')
-		// Found a newline left of the view: force colour map cursor onto next line.
-		next_row(&p->cpos);
-	next_cell(&p->spos, c);
+	int y = view_display_top_row(v)+row-v->lines_top_row;
+	int end_col = v->lines_first_col+view_width(v);
+	int first = first_span_after(hl, v->lines_first_col), n = 0;
+	regmatch_data_t *spans = (regmatch_data_t *)hl->spans.array;
+
+	if (y < 0 || y >= c->rows.len)
+		return;
+	while (first+n < hl->spans.len && spans[first+n].start < end_col)
+		++n;
+	dlist_copy_array(dlist_get_address(&c->rows, y), spans+first, n, NULL);
 }
 
-/*
- * Populate the cells of the colour map with clrpair_t according to the list of regmatch_data_t.
- * @flat_lines_snapshot: string the matches substrings are in
- * @matches: list of regmatch_data_t
- * @v: view used to take flat lines snapshot
- * @extra_lines: see take_flat_lines_snapshot()
- */
-static void clrmap_paint(matrix_t *clrmap, char *flat_lines_snapshot, dlist_t *matches, view_t *v,
-			 int extra_lines)
+bool clrmap_syntax_highlight(clrmap_t *c, fbuf_t *f)
 {
-	regmatch_data_t rdummy, *r, *rnext;
-	struct paint_data p = {
-		.cpos = { view_display_top_row(v), view_display_first_col(v) },
-		.spos = { 0, 0 },
-		.clrmap = clrmap,
-		.v = v,
-		.extra_lines_above = v->lines_top_row < extra_lines ? v->lines_top_row : extra_lines,
-		.nconsec_cols_in_view = 0
-	};
-	int i = 0;  // Current index in the string.
-	int j = 0;  // Current index in matches.
-	int n = strlen(flat_lines_snapshot);
-
-	matrix_memset(clrmap, COLOUR_DEFAULT);
-	// Sort substrings in ascending order of start index so that nested substring matches can 
-	// be skipped.
-	qsort(matches->array, matches->len, sizeof(regmatch_data_t), (int (*)(const void *, const void *))regmatch_data_cmp);
-	rdummy.end = 0;  
-	r = &rdummy;
-
-	while (j < matches->len) {
-		// Skip all substrings inside the current substring, e.g. a keyword inside a string, such as keyword
-		// do inside string "do this".
-		do {
-			rnext = dlist_get_address(matches, j++);
-		} while (j < matches->len && rnext->start < r->end);
-		// Couldn't find any more substrings past the most recently applied substring.
-		if (j == matches->len && rnext->start < r->end)
-			break;
-		r = rnext;
-		// Move past gap before substring.
-		for (; i < n && i < r->start; ++i)
-			paint(&p, COLOUR_DEFAULT, flat_lines_snapshot[i]);
-		// Fill substring with its colour.
-		for (; i < n && i < r->end; ++i)  
-			paint(&p, r->clrpair, flat_lines_snapshot[i]);
+	file_syntax_rules_t *rules = find_syntax_rules(fbuf_link_name(f));
+	int top_row = f->view.lines_top_row;
+	int bot_row = view_lines_bot_row(&f->view, &f->lines);
+	// First row whose highlighting isn't cached, -1 for none, and the state it starts in.
+	int missing = -1;
+	hlstate_t missing_state, state;
+	hlline_t *hl;
+	int len;
+
+	clrmap_clear(c);
+	if (!rules)
+		return false;
+
+	hlworker_lock(&c->worker);
+	if (!start_state(c, f, top_row, rules, &state)) {
+		missing = f->hlstates.known-1;
+		dlist_get(&f->hlstates.states, missing, &missing_state);
+	}
+	for (int row = top_row; row <= bot_row; ++row) {
+		len = line_len(dlist_get_address(&f->lines, row));
+		if (missing == -1 && (!(hl = cached_line(c, f, row, rules, state)) ||
+				      !hlworker_covers(hl, len, &f->view))) {
+			missing = row;
+			missing_state = state;
+		}
+		// Past the first missing row the states aren't known, so rows are painted with the
+		// highlighting they last had.
+		hl = hlworker_get(&c->worker, fbuf_line_version(f, row));
+		if (!hl || hl->rules != rules)
+			continue;
+		paint_line(c, &f->view, row, hl);
+		state = hl->end_state;
 	}
+	if (missing != -1)
+		hlworker_submit(&c->worker, f, missing, bot_row+1-missing, rules, missing_state);
+	hlworker_unlock(&c->worker);
+	return true;
 }
 
-bool clrmap_syntax_highlight(clrmap_t *c, fbuf_t *f)
+dlist_t *clrmap_row_spans(clrmap_t *c, int y)
 {
-	syntax_rule_t *rules = find_syntax_rules(fbuf_link_name(f));
-
-	if (rules) {
-		dlist_t matches;
-		str_t flat_lines_snapshot;
-
-		dlist_init(&matches, DLIST_MIN_CAP, sizeof(regmatch_data_t));
-		str_alloc(&flat_lines_snapshot, DLIST_MIN_CAP);
-
-		clrmap_resz(c);
-		take_flat_lines_snapshot(f, &flat_lines_snapshot, EXTRA_LINES);
-		// Get rid of pseudo spaces so don't have to worry about handling them in regex.
-		str_replace_pspaces(&flat_lines_snapshot);
-		exec_syntax_rules(flat_lines_snapshot.array, rules, &matches);
-		clrmap_paint(&c->clrmap, flat_lines_snapshot.array, &matches, &f->view, EXTRA_LINES);
-
-		dlist_free(&matches, NULL);
-		dlist_free(&flat_lines_snapshot, NULL);
-	} 
-	return rules;
+	return dlist_get_address(&c->rows, y);
 }
 
 void clrmap_free(clrmap_t *c)
 {
-	matrix_free(&c->clrmap);
+	hlworker_free(&c->worker);
+	dlist_free(&c->rows, (dlist_elem_fn)row_free);
 }
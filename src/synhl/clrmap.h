@@ -10,32 +10,45 @@
 #define CLRMAP_H
 
 #include <curses.h>
-#include "../ds/matrix.h"
-#include "../ds/str.h"
 #include "../fbuf/fbuf.h"
 #include "rule.h"
+#include "hlworker.h"
 
 typedef struct colour_map {
-	// Matrix of clrpair_t. Each cell stores the colour of the position on 
-	// the curses window matching the row, column indices of the cell.
-	matrix_t clrmap;
+	// Spans (regmatch_data_t) of each row of the curses window to colour, as a dlist_t per
+	// row. The spans are in order, only those at least partly in view, and have the columns
+	// of the line on the row, which the renderer clips them to the view by. Cells outside any
+	// span are the default colour.
+	dlist_t rows;
 	WINDOW *win;
+	hlworker_t worker;  // Highlights the lines painted.
 } clrmap_t;
 
 /*
- * Initialise a colour map for syntax highlighting.
+ * Initialise a colour map for syntax highlighting, starting its highlight worker.
  */
 void clrmap_init(clrmap_t *c, WINDOW *w);
 
 /*
  * Repaint the colour map with syntax highlighting for a file buffer.
  * Language is chosen from the file type identified by the file's extension.
+ * Lines are painted with their cached highlighting, and those not highlighted yet in the state
+ * they now start in are submitted to the highlight worker, which requests a redraw once they
+ * are. Until then they are painted with the last highlighting they had, or the default colour
+ * if they have none.
+ * Without syntax highlighting for the file the colour map is left without spans.
  *
  * Return whether syntax highlighting is enabled for the file and whether
  * the clrmap was painted.
  */
 bool clrmap_syntax_highlight(clrmap_t *c, fbuf_t *f);
 
+/*
+ * Get the spans (regmatch_data_t) to colour on a row of the curses window, only those in
+ * view of the line on the row.
+ */
+dlist_t *clrmap_row_spans(clrmap_t *c, int y);
+
 /*
  * Free a colour map initialised with clrmap_init().
  */
@@ -0,0 +1,838 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include <ctype.h>
+#include "dfa.h"
+
+#define DFA_UNKNOWN -2  // Transition or start state not worked out yet.
+#define DFA_DEAD -1  // Transition to no state, so no pattern can match any further.
+#define DFA_END 256  // Byte value standing for the end of the text.
+#define DUP_MAX 255  // Largest count in a {m,n} repetition.
+
+enum nfa_type {
+	NFA_EMPTY,  // Moves on to out without matching anything.
+	NFA_SPLIT,  // Moves on to both out and out1.
+	NFA_SET,  // Matches a byte in a set, moving on to out.
+	NFA_ASSERT,  // Moves on to out if an assertion holds at the position.
+	NFA_MATCH  // A pattern has matched.
+};
+
+enum nfa_assert {
+	ASSERT_LINE_START,
+	ASSERT_LINE_END,
+	ASSERT_TEXT_START,
+	ASSERT_TEXT_END,
+	ASSERT_WORD_BOUNDARY,
+	ASSERT_NOT_WORD_BOUNDARY,
+	ASSERT_WORD_START,
+	ASSERT_WORD_END
+};
+
+typedef struct nfa_node {
+	enum nfa_type type;
+	int out, out1;
+	int arg;  // Set index for NFA_SET, nfa_assert for NFA_ASSERT, pattern for NFA_MATCH.
+} nfa_node_t;
+
+typedef struct byteset {
+	uint8_t bits[32];
+} byteset_t;
+
+typedef struct dfa_state {
+	int nodes;  // Index in the pool of the first of the state's NFA nodes.
+	int nnodes;
+	enum dfa_ctx ctx;  // Context of the position the state is at.
+	int next_same_hash;  // Index of the state added before it with the same hash, -1 for none.
+	int next[256];  // State reached by each byte, DFA_DEAD or DFA_UNKNOWN.
+	// Pattern matched at the position when followed by each byte or DFA_END, -1 for none or
+	// DFA_UNKNOWN.
+	short accept[257];
+} dfa_state_t;
+
+/*
+ * Fragment of the NFA of a pattern, entered at start and left through exit, an NFA_EMPTY
+ * node whose out is set once the fragment is joined to the next.
+ */
+struct frag {
+	int start, exit;
+};
+
+struct parser {
+	dfa_t *d;
+	char *p;  // Current position in the pattern.
+	int cflags;
+	char *err;  // Error found, NULL if there is none.
+};
+
+static struct frag parse_alt(struct parser *P);
+
+static nfa_node_t *node(dfa_t *d, int i)
+{
+	return dlist_get_address(&d->nfa, i);
+}
+
+static dfa_state_t *state(dfa_t *d, int i)
+{
+	return dlist_get_address(&d->states, i);
+}
+
+static int node_new(dfa_t *d, enum nfa_type type, int out, int out1, int arg)
+{
+	nfa_node_t n = { type, out, out1, arg };
+
+	dlist_append(&d->nfa, &n);
+	return d->nfa.len-1;
+}
+
+static struct frag frag_empty(dfa_t *d)
+{
+	int e = node_new(d, NFA_EMPTY, -1, -1, 0);
+
+	return (struct frag){ e, e };
+}
+
+static struct frag frag_node(dfa_t *d, enum nfa_type type, int arg)
+{
+	int e = node_new(d, NFA_EMPTY, -1, -1, 0);
+
+	return (struct frag){ node_new(d, type, e, -1, arg), e };
+}
+
+static struct frag frag_cat(dfa_t *d, struct frag a, struct frag b)
+{
+	node(d, a.exit)->out = b.start;
+	return (struct frag){ a.start, b.exit };
+}
+
+static struct frag frag_alt(dfa_t *d, struct frag a, struct frag b)
+{
+	int e = node_new(d, NFA_EMPTY, -1, -1, 0);
+
+	node(d, a.exit)->out = e;
+	node(d, b.exit)->out = e;
+	return (struct frag){ node_new(d, NFA_SPLIT, a.start, b.start, 0), e };
+}
+
+static struct frag frag_star(dfa_t *d, struct frag a)
+{
+	int e = node_new(d, NFA_EMPTY, -1, -1, 0);
+	int s = node_new(d, NFA_SPLIT, a.start, e, 0);
+
+	node(d, a.exit)->out = s;
+	return (struct frag){ s, e };
+}
+
+static struct frag frag_plus(dfa_t *d, struct frag a)
+{
+	int e = node_new(d, NFA_EMPTY, -1, -1, 0);
+	int s = node_new(d, NFA_SPLIT, a.start, e, 0);
+
+	node(d, a.exit)->out = s;
+	return (struct frag){ a.start, e };
+}
+
+static struct frag frag_opt(dfa_t *d, struct frag a)
+{
+	return (struct frag){ node_new(d, NFA_SPLIT, a.start, a.exit, 0), a.exit };
+}
+
+static void set_add(byteset_t *s, int c)
+{
+	s->bits[c >> 3] |= 1 << (c & 7);
+}
+
+static bool set_has(byteset_t *s, int c)
+{
+	return s->bits[c >> 3] & (1 << (c & 7));
+}
+
+static bool is_word(int c)
+{
+	return c < 256 && (isalnum(c) || c == '_');
+}
+
+/*
+ * Add a byte to a set, along with its other case for a case insensitive pattern.
+ */
+static void set_add_case(struct parser *P, byteset_t *s, int c)
+{
+	set_add(s, c);
+	if (P->cflags & REG_ICASE) {
+		set_add(s, tolower(c));
+		set_add(s, toupper(c));
+	}
+}
+
+/*
+ * Add the bytes for which a ctype.h function is true to a set.
+ */
+static void set_add_ctype(byteset_t *s, int (*fn)(int))
+{
+	for (int c = 0; c < 256; ++c) {
+		if (fn(c))
+			set_add(s, c);
+	}
+}
+
+static void set_invert(byteset_t *s)
+{
+	for (int i = 0; i < 32; ++i)
+		s->bits[i] = ~s->bits[i];
+}
+
+static int isword_ctype(int c)
+{
+	return is_word(c);
+}
+
+static struct frag frag_set(struct parser *P, byteset_t *s)
+{
+	dlist_append(&P->d->sets, s);
+	return frag_node(P->d, NFA_SET, P->d->sets.len-1);
+}
+
+/*
+ * Add a character class such as [:alpha:] of a bracket expression to a set.
+ * Return whether the class is known.
+ */
+static bool set_add_class(byteset_t *s, char *name, int n)
+{
+	static const struct {
+		char *name;
+		int (*fn)(int);
+	} classes[] = {
+		{ "alpha", isalpha }, { "digit", isdigit }, { "alnum", isalnum },
+		{ "upper", isupper }, { "lower", islower }, { "space", isspace },
+		{ "blank", isblank }, { "punct", ispunct }, { "print", isprint },
+		{ "graph", isgraph }, { "cntrl", iscntrl }, { "xdigit", isxdigit }
+	};
+
+	for (int i = 0; i < sizeof(classes)/sizeof(classes[0]); ++i) {
+		if (strlen(classes[i].name) == n && !strncmp(classes[i].name, name, n)) {
+			set_add_ctype(s, classes[i].fn);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Parse a bracket expression, P->p being just after its '['.
+ */
+static struct frag parse_bracket(struct parser *P)
+{
+	byteset_t s = { 0 };
+	bool invert = false, first = true;
+	char *end;
+	int lo, hi;
+
+	if (*P->p == '^') {
+		invert = true;
+		++P->p;
+	}
+	for (; *P->p && (first || *P->p != ']'); first = false) {
+		if (P->p[0] == '[' && (P->p[1] == ':' || P->p[1] == '.' || P->p[1] == '=')) {
+			end = strchr(P->p+2, P->p[1]);
+			if (!end || end[1] != ']') {
+				P->err = "unterminated character class";
+				return frag_empty(P->d);
+			}
+			if (P->p[1] == ':' && !set_add_class(&s, P->p+2, end-P->p-2)) {
+				P->err = "unknown character class";
+				return frag_empty(P->d);
+			}
+			// Collating elements and equivalence classes are only single characters here.
+			if (P->p[1] != ':')
+				set_add_case(P, &s, (unsigned char)P->p[2]);
+			P->p = end+2;
+			continue;
+		}
+		lo = (unsigned char)*P->p++;
+		hi = lo;
+		if (P->p[0] == '-' && P->p[1] && P->p[1] != ']') {
+			hi = (unsigned char)P->p[1];
+			P->p += 2;
+			if (hi < lo) {
+				P->err = "invalid range end";
+				return frag_empty(P->d);
+			}
+		}
+		for (int c = lo; c <= hi; ++c)
+			set_add_case(P, &s, c);
+	}
+	if (*P->p != ']') {
+		P->err = "unmatched [";
+		return frag_empty(P->d);
+	}
+	++P->p;
+	if (invert)
+		set_invert(&s);
+	return frag_set(P, &s);
+}
+
+/*
+ * Parse an escape outside a bracket expression, P->p being just after its '\'.
+ */
+static struct frag parse_escape(struct parser *P)
+{
+	byteset_t s = { 0 };
+	char c = *P->p++;
+
+	switch (c) {
+	case '\0':
+		--P->p;
+		P->err = "trailing backslash";
+		return frag_empty(P->d);
+	case 'w':
+	case 'W':
+		set_add_ctype(&s, isword_ctype);
+		if (c == 'W')
+			set_invert(&s);
+		return frag_set(P, &s);
+	case 's':
+	case 'S':
+		set_add_ctype(&s, isspace);
+		if (c == 'S')
+			set_invert(&s);
+		return frag_set(P, &s);
+	case 'b':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_WORD_BOUNDARY);
+	case 'B':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_NOT_WORD_BOUNDARY);
+	case '<':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_WORD_START);
+	case '>':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_WORD_END);
+	case '`':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_TEXT_START);
+	case '\'':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_TEXT_END);
+	default:
+		set_add_case(P, &s, (unsigned char)c);
+		return frag_set(P, &s);
+	}
+}
+
+static struct frag parse_atom(struct parser *P)
+{
+	byteset_t s = { 0 };
+	struct frag f;
+	char c = *P->p++;
+
+	switch (c) {
+	case '(':
+		f = parse_alt(P);
+		if (P->err)
+			return f;
+		if (*P->p != ')') {
+			P->err = "unmatched (";
+			return f;
+		}
+		++P->p;
+		return f;
+	case '[':
+		return parse_bracket(P);
+	case '.':
+		for (int i = 0; i < 256; ++i) {
+			if (i != '\n' || !(P->cflags & REG_NEWLINE))
+				set_add(&s, i);
+		}
+		return frag_set(P, &s);
+	case '^':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_LINE_START);
+	case '$':
+		return frag_node(P->d, NFA_ASSERT, ASSERT_LINE_END);
+	case '\\':
+		return parse_escape(P);
+	default:
+		set_add_case(P, &s, (unsigned char)c);
+		return frag_set(P, &s);
+	}
+}
+
+/*
+ * Parse the count of a {m,n} repetition, P->p being just after its '{'.
+ * @out_max: out-param n, -1 for no maximum
+ * Return m, or -1 for an invalid count.
+ */
+static int parse_count(struct parser *P, int *out_max)
+{
+	int min = strtol(P->p, &P->p, 10);
+
+	*out_max = min;
+	if (*P->p == ',') {
+		++P->p;
+		*out_max = isdigit(*P->p) ? strtol(P->p, &P->p, 10) : -1;
+	}
+	if (*P->p != '}' || min > DUP_MAX || *out_max > DUP_MAX ||
+	    (*out_max != -1 && *out_max < min)) {
+		P->err = "invalid repetition count";
+		return -1;
+	}
+	++P->p;
+	return min;
+}
+
+/*
+ * Parse an atom followed by any number of repetition operators, stopping at limit if the atom
+ * is being parsed again to copy it.
+ */
+static struct frag parse_repeat(struct parser *P, char *limit)
+{
+	char *atom = P->p, *before, *after;
+	struct frag f = parse_atom(P), copy;
+	int min, max;
+
+	while (!P->err && (!limit || P->p < limit)) {
+		if (*P->p == '*') {
+			f = frag_star(P->d, f);
+		} else if (*P->p == '+') {
+			f = frag_plus(P->d, f);
+		} else if (*P->p == '?') {
+			f = frag_opt(P->d, f);
+		} else if (*P->p == '{' && isdigit(P->p[1])) {
+			// A {m,n} repetition is made of copies of what's repeated, each parsed again
+			// from the pattern.
+			before = P->p++;
+			if ((min = parse_count(P, &max)) == -1)
+				break;
+			after = P->p;
+			f = frag_empty(P->d);
+			for (int i = 0; i < min || i < max || (i == min && max == -1); ++i) {
+				P->p = atom;
+				copy = parse_repeat(P, before);
+				if (i >= min)
+					copy = max == -1 ? frag_star(P->d, copy) : frag_opt(P->d, copy);
+				f = frag_cat(P->d, f, copy);
+			}
+			P->p = after;
+			continue;
+		} else {
+			break;
+		}
+		++P->p;
+	}
+	return f;
+}
+
+static struct frag parse_concat(struct parser *P)
+{
+	struct frag f = frag_empty(P->d);
+
+	while (!P->err && *P->p && *P->p != '|' && *P->p != ')')
+		f = frag_cat(P->d, f, parse_repeat(P, NULL));
+	return f;
+}
+
+static struct frag parse_alt(struct parser *P)
+{
+	struct frag f = parse_concat(P);
+
+	while (!P->err && *P->p == '|') {
+		++P->p;
+		f = frag_alt(P->d, f, parse_concat(P));
+	}
+	return f;
+}
+
+/*
+ * Throw away every DFA state, such as once the NFA changes or there are too many states.
+ */
+static void dfa_flush(dfa_t *d)
+{
+	dlist_resize_len(&d->states, 0);
+	dlist_resize_len(&d->pool, 0);
+	hmap_clear(&d->index, NULL);
+	for (int i = 0; i < DFA_NCTX; ++i)
+		d->start_states[i] = DFA_UNKNOWN;
+}
+
+void dfa_init(dfa_t *d)
+{
+	dlist_init(&d->nfa, DLIST_MIN_CAP, sizeof(nfa_node_t));
+	dlist_init(&d->sets, DLIST_MIN_CAP, sizeof(byteset_t));
+	dlist_init(&d->starts, DLIST_MIN_CAP, sizeof(int));
+	d->npats = 0;
+	dlist_init(&d->states, DLIST_MIN_CAP, sizeof(dfa_state_t));
+	dlist_init(&d->pool, DLIST_MIN_CAP, sizeof(int));
+	hmap_init(&d->index, HMAP_MIN_CAP, sizeof(int));
+	dlist_init(&d->stack, DLIST_MIN_CAP, sizeof(int));
+	dlist_init(&d->found, DLIST_MIN_CAP, sizeof(int));
+	dlist_init(&d->targets, DLIST_MIN_CAP, sizeof(int));
+	dlist_init(&d->marks, DLIST_MIN_CAP, sizeof(int));
+	d->mark_gen = 0;
+	for (int c = 0; c < 256; ++c)
+		d->alias[c] = c;
+	dfa_flush(d);
+}
+
+void dfa_free(dfa_t *d)
+{
+	dlist_free(&d->nfa, NULL);
+	dlist_free(&d->sets, NULL);
+	dlist_free(&d->starts, NULL);
+	dlist_free(&d->states, NULL);
+	dlist_free(&d->pool, NULL);
+	hmap_free(&d->index, NULL);
+	dlist_free(&d->stack, NULL);
+	dlist_free(&d->found, NULL);
+	dlist_free(&d->targets, NULL);
+	dlist_free(&d->marks, NULL);
+}
+
+bool dfa_add(dfa_t *d, char *pat, int cflags, char *errbuf, int errbufsz)
+{
+	struct parser P = { d, pat, cflags, NULL };
+	int nnodes = d->nfa.len, nsets = d->sets.len;
+	int start = -1;
+	struct frag f;
+
+	f = parse_alt(&P);
+	if (!P.err && *P.p)
+		P.err = "unmatched )";
+
+	if (P.err) {
+		dlist_resize_len(&d->nfa, nnodes);
+		dlist_resize_len(&d->sets, nsets);
+		snprintf(errbuf, errbufsz, "%s at offset %ld", P.err, (long)(P.p-pat));
+	} else {
+		node(d, f.exit)->out = node_new(d, NFA_MATCH, -1, -1, d->npats);
+		start = f.start;
+	}
+	dlist_append(&d->starts, &start);
+	++d->npats;
+
+	dlist_resize_len(&d->marks, d->nfa.len);
+	dlist_memset(&d->marks, 0);
+	d->mark_gen = 0;
+	dfa_flush(d);
+	return !P.err;
+}
+
+void dfa_disable(dfa_t *d, int pat)
+{
+	// The nodes of the pattern stay in the NFA, but can't be reached without its start.
+	*(int *)dlist_get_address(&d->starts, pat) = -1;
+	dfa_flush(d);
+}
+
+void dfa_alias(dfa_t *d, int c, int as)
+{
+	d->alias[(unsigned char)c] = as;
+	dfa_flush(d);
+}
+
+/*
+ * Write a list's length and elements to a file.
+ */
+static bool write_list(dlist_t *l, FILE *fp)
+{
+	return fwrite(&l->len, sizeof(int), 1, fp) == 1 &&
+	       fwrite(l->array, l->eltsz, l->len, fp) == l->len;
+}
+
+/*
+ * Read a list written by write_list() from a file, appending its elements.
+ * @max: most elements the list can have
+ */
+static bool read_list(dlist_t *l, FILE *fp, int max)
+{
+	int len, start = l->len;
+
+	if (fread(&len, sizeof(int), 1, fp) != 1 || len < 0 || len > max)
+		return false;
+	dlist_resize_len(l, start+len);
+	return fread(dlist_get_address(l, start), l->eltsz, len, fp) == len;
+}
+
+bool dfa_write(dfa_t *d, FILE *fp)
+{
+	return fwrite(&d->npats, sizeof(int), 1, fp) == 1 && write_list(&d->nfa, fp) &&
+	       write_list(&d->sets, fp) && write_list(&d->starts, fp);
+}
+
+/*
+ * Get whether an NFA node index read from a file is valid, -1 being valid if it's allowed.
+ */
+static bool valid_node(dfa_t *d, int i, bool none_allowed)
+{
+	return (i >= 0 && i < d->nfa.len) || (none_allowed && i == -1);
+}
+
+bool dfa_read(dfa_t *d, FILE *fp)
+{
+	// Most nodes and sets a cached scanner can have, to catch corrupt files.
+	const int max = 1 << 24;
+	nfa_node_t *n;
+	int *starts;
+
+	if (fread(&d->npats, sizeof(int), 1, fp) != 1 || d->npats < 0 || d->npats > max ||
+	    !read_list(&d->nfa, fp, max) || !read_list(&d->sets, fp, max) ||
+	    !read_list(&d->starts, fp, max) || d->starts.len != d->npats)
+		return false;
+
+	// A corrupt file mustn't leave nodes pointing outside the NFA.
+	for (int i = 0; i < d->nfa.len; ++i) {
+		n = node(d, i);
+		if (!valid_node(d, n->out, true) || !valid_node(d, n->out1, true))
+			return false;
+		if ((n->type == NFA_SET && (n->arg < 0 || n->arg >= d->sets.len)) ||
+		    (n->type == NFA_ASSERT && (n->arg < ASSERT_LINE_START || n->arg > ASSERT_WORD_END)) ||
+		    (n->type == NFA_MATCH && (n->arg < 0 || n->arg >= d->npats)) ||
+		    n->type < NFA_EMPTY || n->type > NFA_MATCH)
+			return false;
+	}
+	starts = (int *)d->starts.array;
+	for (int i = 0; i < d->starts.len; ++i) {
+		if (!valid_node(d, starts[i], true))
+			return false;
+	}
+
+	dlist_resize_len(&d->marks, d->nfa.len);
+	dlist_memset(&d->marks, 0);
+	d->mark_gen = 0;
+	dfa_flush(d);
+	return true;
+}
+
+static bool assert_holds(enum nfa_assert a, enum dfa_ctx ctx, int c)
+{
+	bool prev_word = ctx == DFA_CTX_WORD;
+	bool next_word = is_word(c);
+
+	switch (a) {
+	case ASSERT_LINE_START:
+		return ctx == DFA_CTX_START || ctx == DFA_CTX_NEWLINE;
+	case ASSERT_LINE_END:
+		return c == DFA_END || c == '\n';
+	case ASSERT_TEXT_START:
+		return ctx == DFA_CTX_START;
+	case ASSERT_TEXT_END:
+		return c == DFA_END;
+	case ASSERT_WORD_BOUNDARY:
+		return prev_word != next_word;
+	case ASSERT_NOT_WORD_BOUNDARY:
+		return prev_word == next_word;
+	case ASSERT_WORD_START:
+		return !prev_word && next_word;
+	case ASSERT_WORD_END:
+		return prev_word && !next_word;
+	}
+	return false;
+}
+
+static enum dfa_ctx ctx_of(int c)
+{
+	if (c == '\n')
+		return DFA_CTX_NEWLINE;
+	return is_word(c) ? DFA_CTX_WORD : DFA_CTX_OTHER;
+}
+
+/*
+ * Add the NFA nodes that can be reached from a node without matching a byte to a list,
+ * skipping nodes already marked in the current generation. Only nodes that match a byte or
+ * are a match are added, along with assertions unless they're resolved.
+ * @resolve: whether to follow assertions that hold at a position, otherwise they're added
+ * @ctx: context of the position
+ * @c: byte after the position, or DFA_END
+ */
+static void closure(dfa_t *d, int start, dlist_t *out, bool resolve, enum dfa_ctx ctx, int c)
+{
+	int *marks = (int *)d->marks.array;
+	nfa_node_t *n;
+	int i;
+
+	dlist_append(&d->stack, &start);
+	while (dlist_pop(&d->stack, &i)) {
+		if (i < 0 || marks[i] == d->mark_gen)
+			continue;
+		marks[i] = d->mark_gen;
+		n = node(d, i);
+		if (n->type == NFA_EMPTY) {
+			dlist_append(&d->stack, &n->out);
+		} else if (n->type == NFA_SPLIT) {
+			dlist_append(&d->stack, &n->out1);
+			dlist_append(&d->stack, &n->out);
+		} else if (n->type == NFA_ASSERT && resolve) {
+			if (assert_holds(n->arg, ctx, c))
+				dlist_append(&d->stack, &n->out);
+		} else {
+			dlist_append(out, &i);
+		}
+	}
+}
+
+static int int_cmp(const int *a, const int *b)
+{
+	return *a - *b;
+}
+
+static unsigned long hash_nodes(int *nodes, int n, enum dfa_ctx ctx)
+{
+	unsigned long h = 14695981039346656037ul ^ ctx;
+
+	for (int i = 0; i < n; ++i)
+		h = (h ^ nodes[i])*1099511628211ul;
+	// Keys of the index must be non-zero.
+	return h | 1;
+}
+
+/*
+ * Get the DFA state of a sorted list of NFA nodes at a position with a context, adding it if
+ * there isn't one yet.
+ */
+static int intern(dfa_t *d, dlist_t *nodes, enum dfa_ctx ctx)
+{
+	unsigned long h = hash_nodes((int *)nodes->array, nodes->len, ctx);
+	int *first = hmap_get(&d->index, h);
+	dfa_state_t *s;
+	int i;
+
+	for (i = first ? *first : -1; i >= 0; i = s->next_same_hash) {
+		s = state(d, i);
+		if (s->ctx == ctx && s->nnodes == nodes->len &&
+		    !memcmp(dlist_get_address(&d->pool, s->nodes), nodes->array,
+			    nodes->len*sizeof(int)))
+			return i;
+	}
+
+	dlist_resize_len(&d->states, d->states.len+1);
+	i = d->states.len-1;
+	s = state(d, i);
+	s->nodes = d->pool.len;
+	s->nnodes = nodes->len;
+	s->ctx = ctx;
+	s->next_same_hash = first ? *first : -1;
+	for (int c = 0; c < 256; ++c)
+		s->next[c] = DFA_UNKNOWN;
+	for (int c = 0; c <= DFA_END; ++c)
+		s->accept[c] = DFA_UNKNOWN;
+	dlist_resize_len(&d->pool, d->pool.len+nodes->len);
+	memcpy(dlist_get_address(&d->pool, s->nodes), nodes->array, nodes->len*sizeof(int));
+	hmap_put(&d->index, h, &i);
+	return i;
+}
+
+/*
+ * Get the DFA state made of the NFA nodes reachable from the start of each pattern.
+ */
+static int start_state(dfa_t *d, enum dfa_ctx ctx)
+{
+	int start;
+
+	if (d->start_states[ctx] != DFA_UNKNOWN)
+		return d->start_states[ctx];
+	++d->mark_gen;
+	dlist_resize_len(&d->found, 0);
+	for (int i = 0; i < d->starts.len; ++i) {
+		dlist_get(&d->starts, i, &start);
+		closure(d, start, &d->found, false, ctx, 0);
+	}
+	qsort(d->found.array, d->found.len, sizeof(int),
+	      (int (*)(const void *, const void *))int_cmp);
+	return d->start_states[ctx] = intern(d, &d->found, ctx);
+}
+
+/*
+ * Work out the pattern a DFA state accepts when followed by a byte, and the state it moves on
+ * to on matching the byte.
+ * @c: the byte, or DFA_END
+ */
+static void transition(dfa_t *d, int si, int c)
+{
+	dfa_state_t *s = state(d, si);
+	// The byte the state's tables are for is looked at as the byte it's an alias of.
+	int as = c == DFA_END ? c : d->alias[c];
+	int accept = -1, next = DFA_DEAD;
+	int nodes = s->nodes, nnodes = s->nnodes;
+	enum dfa_ctx ctx = s->ctx;
+	nfa_node_t *n;
+	int k;
+
+	// Resolve the assertions of the state now that the byte after it is known.
+	++d->mark_gen;
+	dlist_resize_len(&d->found, 0);
+	for (int i = 0; i < nnodes; ++i) {
+		dlist_get(&d->pool, nodes+i, &k);
+		closure(d, k, &d->found, true, ctx, as);
+	}
+
+	dlist_resize_len(&d->targets, 0);
+	for (int i = 0; i < d->found.len; ++i) {
+		dlist_get(&d->found, i, &k);
+		n = node(d, k);
+		if (n->type == NFA_MATCH && (accept == -1 || n->arg < accept))
+			accept = n->arg;
+		else if (n->type == NFA_SET && c != DFA_END &&
+			 set_has(dlist_get_address(&d->sets, n->arg), as))
+			dlist_append(&d->targets, &n->out);
+	}
+
+	if (c != DFA_END && d->targets.len) {
+		++d->mark_gen;
+		dlist_resize_len(&d->found, 0);
+		for (int i = 0; i < d->targets.len; ++i) {
+			dlist_get(&d->targets, i, &k);
+			closure(d, k, &d->found, false, ctx, 0);
+		}
+		qsort(d->found.array, d->found.len, sizeof(int),
+		      (int (*)(const void *, const void *))int_cmp);
+		if (d->found.len)
+			next = intern(d, &d->found, ctx_of(as));
+	}
+
+	// Adding a state can move the states.
+	s = state(d, si);
+	s->accept[c] = accept;
+	if (c != DFA_END)
+		s->next[c] = next;
+}
+
+int dfa_match(dfa_t *d, char *text, int n, int pos, int *out_end)
+{
+	int si, c, accept, best = -1;
+	bool best_empty = false;
+	dfa_state_t *s;
+
+	// States are only thrown away between matches, since a match holds on to its state.
+	if (d->states.len >= DFA_MAX_STATES)
+		dfa_flush(d);
+	si = start_state(d, pos ? ctx_of(d->alias[(unsigned char)text[pos-1]]) : DFA_CTX_START);
+
+	for (int i = pos; ; ++i) {
+		c = i < n ? (unsigned char)text[i] : DFA_END;
+		s = state(d, si);
+		if (s->accept[c] == DFA_UNKNOWN) {
+			transition(d, si, c);
+			s = state(d, si);
+		}
+		accept = s->accept[c];
+		// Only a pattern added before the one matched so far can take over the match, unless
+		// only the empty string was matched, so that a pattern such as "x*" doesn't keep
+		// those after it from ever matching.
+		if (accept != -1 && (best == -1 || accept <= best || (best_empty && i > pos))) {
+			best = accept;
+			best_empty = i == pos;
+			*out_end = i;
+		}
+		if (c == DFA_END || s->next[c] == DFA_DEAD)
+			break;
+		si = s->next[c];
+	}
+	return best;
+}
+
+int dfa_search(dfa_t *d, char *text, int n, int from, int *out_start, int *out_end)
+{
+	int pat;
+
+	for (int pos = from; pos <= n; ++pos) {
+		if ((pat = dfa_match(d, text, n, pos, out_end)) != -1) {
+			*out_start = pos;
+			return pat;
+		}
+	}
+	return -1;
+}
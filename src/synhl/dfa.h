@@ -0,0 +1,137 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Scanner matching many POSIX extended regexes at once. The regexes are compiled into
+ * a single NFA, which is turned into a DFA lazily: a DFA state and its transitions are
+ * only worked out the first time the scanner reaches them, then kept for later scans.
+ * Each byte scanned is a single table lookup once the DFA states it passes through are
+ * known, with no backtracking.
+ *
+ * Supported are the ERE operators | * + ? {m,n} ( ), bracket expressions including
+ * [:class:], . ^ $ and the GNU escapes \w \W \s \S \b \B \< \> \` \'. Other escaped
+ * characters are literal. Back references aren't supported.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef DFA_H
+#define DFA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <regex.h>
+#include "../ds/dlist.h"
+#include "../ds/hmap.h"
+
+// Most DFA states kept before they're all thrown away to be worked out again as needed.
+#define DFA_MAX_STATES 1024
+
+// Context of a position in the text, set by the byte before it, that assertions such as
+// \b depend on.
+enum dfa_ctx {
+	DFA_CTX_START,  // Start of the text.
+	DFA_CTX_WORD,  // After a word character.
+	DFA_CTX_NEWLINE,  // After a newline.
+	DFA_CTX_OTHER,  // After any other character.
+	DFA_NCTX
+};
+
+typedef struct dfa {
+	dlist_t nfa;  // nfa_node_t of the NFA of every pattern.
+	dlist_t sets;  // Sets of bytes (byteset_t) that NFA nodes match.
+	dlist_t starts;  // Start NFA node (int) of each pattern, -1 for one that didn't compile.
+	int npats;  // Number of patterns added.
+	uint8_t alias[256];  // Byte each byte is scanned as, itself unless set by dfa_alias().
+	dlist_t states;  // DFA states (dfa_state_t) worked out so far.
+	dlist_t pool;  // NFA nodes (int) making up each DFA state, in order.
+	hmap_t index;  // Index (int) of the latest DFA state with a hash of its NFA nodes.
+	int start_states[DFA_NCTX];  // Start DFA state for each context, -2 until worked out.
+	// Scratch space for working out DFA states.
+	dlist_t stack;
+	dlist_t found;
+	dlist_t targets;
+	dlist_t marks;
+	int mark_gen;
+} dfa_t;
+
+/*
+ * dfa_init - Initialise a scanner without any patterns
+ *
+ * Free with dfa_free().
+ */
+void dfa_init(dfa_t *d);
+
+/*
+ * dfa_free - Free a scanner
+ */
+void dfa_free(dfa_t *d);
+
+/*
+ * dfa_add - Add a pattern to a scanner, its index being the number of patterns added before it
+ * @pat: POSIX extended regex
+ * @cflags: REG_ICASE for case insensitive matching, REG_NEWLINE for . to not match newlines.
+ *	Other flags are ignored.
+ * @errbuf: out-param error message if the pattern couldn't be compiled
+ * @errbufsz: size of errbuf
+ *
+ * A pattern that couldn't be compiled still takes an index but never matches.
+ * Return whether the pattern was compiled.
+ */
+bool dfa_add(dfa_t *d, char *pat, int cflags, char *errbuf, int errbufsz);
+
+/*
+ * dfa_disable - Stop a pattern from matching, as if it hadn't compiled
+ * @pat: index of the pattern
+ *
+ * The pattern keeps its index, and the scanner no longer spends any time on it.
+ */
+void dfa_disable(dfa_t *d, int pat);
+
+/*
+ * dfa_write - Write the patterns compiled into a scanner to a file, to be read back with
+ *	dfa_read() by the same build of the program
+ *
+ * The DFA states and the aliases (see dfa_alias()) aren't written.
+ * Return whether the patterns were written.
+ */
+bool dfa_write(dfa_t *d, FILE *fp);
+
+/*
+ * dfa_read - Read patterns written by dfa_write() into a scanner without any patterns
+ *
+ * On failure the scanner is left in an unknown state and should be freed.
+ * Return whether the patterns were read and are valid.
+ */
+bool dfa_read(dfa_t *d, FILE *fp);
+
+/*
+ * dfa_alias - Scan a byte as if it were another byte, e.g. to have bytes standing for
+ *	another character in the text matched as that character
+ * @c: byte to scan as another
+ * @as: byte it's scanned as, which mustn't itself be an alias
+ */
+void dfa_alias(dfa_t *d, int c, int as);
+
+/*
+ * dfa_match - Match the patterns at a position in text
+ * @n: length of text
+ * @pos: index to match at
+ * @out_end: out-param end (exclusive) of the match
+ *
+ * Of the patterns matching at the position, the one added first is matched, with the
+ * longest match it has there. A pattern matching only the empty string there is matched
+ * only if no other pattern matches more.
+ * Return the index of the pattern matched, or -1 if none match.
+ */
+int dfa_match(dfa_t *d, char *text, int n, int pos, int *out_end);
+
+/*
+ * dfa_search - Find the first position from an index in text where the patterns match
+ * @out_start: out-param start of the match
+ *
+ * See dfa_match() for the rest of the params.
+ * Return the index of the pattern matched, or -1 if none match.
+ */
+int dfa_search(dfa_t *d, char *text, int n, int from, int *out_start, int *out_end);
+
+#endif
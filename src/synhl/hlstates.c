@@ -0,0 +1,88 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "hlstates.h"
+
+void hlstates_init(hlstates_t *s)
+{
+	dlist_init(&s->states, DLIST_MIN_CAP, sizeof(int));
+	s->known = 0;
+	s->dirty_end = 0;
+}
+
+void hlstates_free(hlstates_t *s)
+{
+	dlist_free(&s->states, NULL);
+}
+
+void hlstates_copy_new(hlstates_t *src, hlstates_t *out_s)
+{
+	dlist_copy_new(&src->states, &out_s->states);
+	out_s->known = src->known;
+	out_s->dirty_end = src->dirty_end;
+}
+
+void hlstates_reset(hlstates_t *s)
+{
+	dlist_resize_len(&s->states, 0);
+	s->known = 0;
+	s->dirty_end = 0;
+}
+
+void hlstates_splice(hlstates_t *s, int row, int nold, int nnew)
+{
+	if (row >= s->states.len)
+		return;
+	if (row+nold > s->states.len) {
+		// The states after the replaced rows weren't found yet.
+		dlist_resize_len(&s->states, row);
+		s->dirty_end = row;
+	} else {
+		dlist_splice_zeroed(&s->states, row, nold, nnew);
+		// Rows changed before that have all been found again since are no longer unknown.
+		if (s->dirty_end <= s->known)
+			s->dirty_end = row+nnew;
+		else if (s->dirty_end > row+nold)
+			s->dirty_end += nnew-nold;
+		else if (s->dirty_end < row+nnew)
+			s->dirty_end = row+nnew;
+	}
+	// The state of the first row replaced follows unchanged lines but its old state could
+	// have been that of a deleted row, so it's found again too.
+	if (s->known > row)
+		s->known = row;
+}
+
+bool hlstates_find(hlstates_t *s, int row, hlstates_end_fn end_fn, void *data, int *out_state)
+{
+	int *states;
+	int r, end;
+
+	if (!s->known) {
+		dlist_resize_len(&s->states, s->states.len ? s->states.len : 1);
+		*(int *)dlist_get_address(&s->states, 0) = 0;
+		s->known = 1;
+	}
+
+	while (s->known <= row) {
+		r = s->known;
+		states = (int *)s->states.array;
+		if (!end_fn(r-1, states[r-1], data, &end))
+			return false;
+		if (r == s->states.len) {
+			dlist_append(&s->states, &end);
+		} else if (r >= s->dirty_end && states[r] == end) {
+			// The lines from here on are unchanged and start in the same state as before,
+			// so their kept states still hold.
+			s->known = s->states.len;
+			continue;
+		} else {
+			states[r] = end;
+		}
+		++s->known;
+	}
+	dlist_get(&s->states, row, out_state);
+	return true;
+}
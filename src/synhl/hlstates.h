@@ -0,0 +1,77 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * States (int, see rule.h) that syntax highlighting starts each line of a file buffer in,
+ * kept in sync with its lines as they're edited. The state of a line depends on every line
+ * before it, so an edit makes the states after it unknown until they're found again from the
+ * states the lines before them end in. Once a line after the edited ones is found to start in
+ * the same state as before, the states after it still hold and needn't be found again.
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef HLSTATES_H
+#define HLSTATES_H
+
+#include <stdbool.h>
+#include "../ds/dlist.h"
+
+typedef struct hlstates {
+	// State (int) of each row found so far, which may be fewer rows than the lines. The
+	// states of the rows before known are certain. Those of the rows from there to before
+	// dirty_end follow lines changed since, so are unknown. The states after that follow
+	// unchanged lines, so all become certain again once one is found to be unchanged.
+	dlist_t states;
+	int known;
+	int dirty_end;
+} hlstates_t;
+
+/*
+ * Function getting the state a row ends in from the state it starts in.
+ * @data: data passed along with the function
+ * @out_state: out-param state the row ends in
+ *
+ * Return false if it isn't known.
+ */
+typedef bool (*hlstates_end_fn)(int row, int start_state, void *data, int *out_state);
+
+/*
+ * hlstates_init - Initialise states without any found
+ *
+ * Free with hlstates_free().
+ */
+void hlstates_init(hlstates_t *s);
+
+void hlstates_free(hlstates_t *s);
+
+/*
+ * hlstates_copy_new - Initialise states as a copy of others
+ */
+void hlstates_copy_new(hlstates_t *src, hlstates_t *out_s);
+
+/*
+ * hlstates_reset - Forget every state found, as when the rules highlighting the lines change
+ */
+void hlstates_reset(hlstates_t *s);
+
+/*
+ * hlstates_splice - Update states after rows of their lines have been replaced
+ * @row: first row replaced
+ * @nold: number of rows replaced
+ * @nnew: number of rows that replaced them
+ *
+ * The states of the rows replaced and any after them are unknown until found again.
+ */
+void hlstates_splice(hlstates_t *s, int row, int nold, int nnew);
+
+/*
+ * hlstates_find - Get the state a row starts in, first finding the states of the rows before
+ *	it that aren't known, from the last known one
+ * @end_fn: gets the state each row before it ends in
+ * @out_state: out-param state of the row
+ *
+ * The first row always starts in state 0, outside any region. Return false if end_fn didn't
+ * know the state a row before it ends in, in which case that row is known-1.
+ */
+bool hlstates_find(hlstates_t *s, int row, hlstates_end_fn end_fn, void *data, int *out_state);
+
+#endif
@@ -0,0 +1,324 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#include "hlworker.h"
+#include "../redraw.h"
+
+static void hlreq_init(hlreq_t *r)
+{
+	r->rules = NULL;
+	str_alloc(&r->text, DLIST_MIN_CAP);
+	dlist_init(&r->lines, DLIST_MIN_CAP, sizeof(hlreq_line_t));
+}
+
+static void hlreq_free(hlreq_t *r)
+{
+	dlist_free(&r->text, NULL);
+	dlist_free(&r->lines, NULL);
+}
+
+static void hlreq_clear(hlreq_t *r)
+{
+	dlist_resize_len(&r->text, 0);
+	dlist_resize_len(&r->lines, 0);
+}
+
+/*
+ * Add a line to a request, with the text of the part of it to scan as it's stored.
+ */
+static void hlreq_add_line(hlreq_t *r, line_t *l, unsigned long version, view_t *v)
+{
+	hlreq_line_t rl = { .version = version, .start = r->text.len };
+	int len = line_len(l);
+
+	hlworker_window(len, v, &rl.first_col, &rl.end_col);
+	rl.whole = rl.first_col == 0 && rl.end_col == len;
+	rl.col = rl.first_col > HLLINE_LOOKAROUND ? rl.first_col-HLLINE_LOOKAROUND : 0;
+	rl.len = (rl.end_col+HLLINE_LOOKAROUND < len ? rl.end_col+HLLINE_LOOKAROUND : len)-rl.col;
+	dlist_insert_array(&r->text, r->text.len, l->array+rl.col, rl.len);
+	dlist_append(&r->lines, &rl);
+}
+
+static void hlline_free(hlline_t *hl)
+{
+	dlist_free(&hl->spans, NULL);
+}
+
+/*
+ * Unlink a cached line from the LRU list.
+ */
+static void lru_unlink(hlworker_t *w, hlline_t *hl)
+{
+	if (hl->lru_prev)
+		((hlline_t *)hmap_get(&w->cache, hl->lru_prev))->lru_next = hl->lru_next;
+	else
+		w->lru_head = hl->lru_next;
+	if (hl->lru_next)
+		((hlline_t *)hmap_get(&w->cache, hl->lru_next))->lru_prev = hl->lru_prev;
+	else
+		w->lru_tail = hl->lru_prev;
+}
+
+/*
+ * Link a cached line into the LRU list as the most recently used.
+ */
+static void lru_push(hlworker_t *w, unsigned long version, hlline_t *hl)
+{
+	hl->lru_prev = 0;
+	hl->lru_next = w->lru_head;
+	if (w->lru_head)
+		((hlline_t *)hmap_get(&w->cache, w->lru_head))->lru_prev = version;
+	else
+		w->lru_tail = version;
+	w->lru_head = version;
+}
+
+/*
+ * Evict the least recently used line from the cache.
+ */
+static void cache_evict(hlworker_t *w)
+{
+	unsigned long version = w->lru_tail;
+	hlline_t *hl = hmap_get(&w->cache, version);
+
+	lru_unlink(w, hl);
+	w->cache_bytes -= hl->size;
+	hmap_delete(&w->cache, version, (dlist_elem_fn)hlline_free);
+}
+
+/*
+ * Empty the cache. Requires the lock to be held.
+ */
+static void cache_clear(hlworker_t *w)
+{
+	hmap_clear(&w->cache, (dlist_elem_fn)hlline_free);
+	w->lru_head = 0;
+	w->lru_tail = 0;
+	w->cache_bytes = 0;
+}
+
+/*
+ * Cache the highlighting of a line version, replacing any cached before, then evict the least
+ * recently used lines until the cache is within its budget. Lines edited away or of closed
+ * file buffers are never used again, so are the first to go. Requires the lock to be held.
+ */
+static void cache_put(hlworker_t *w, unsigned long version, hlline_t *hl)
+{
+	hlline_t *old = hmap_get(&w->cache, version);
+
+	if (old) {
+		lru_unlink(w, old);
+		w->cache_bytes -= old->size;
+		hlline_free(old);
+	}
+	hl->size = sizeof(unsigned long)+sizeof(hlline_t)+hl->spans.capacity*hl->spans.eltsz;
+	hl = hmap_put(&w->cache, version, hl);
+	lru_push(w, version, hl);
+	w->cache_bytes += hl->size;
+	// Keep at least the line just cached, however big.
+	while (w->cache_bytes > HLCACHE_MAX_BYTES && w->lru_tail != version)
+		cache_evict(w);
+}
+
+/*
+ * Disable the rules that have spent more than HLRULE_MAX_NSEC highlighting their own matches
+ * since some earlier stats, throwing away the highlighting done with them. Time spent scanning
+ * where no rule matched isn't put down to any rule, so never disables one.
+ * @before: stats (syntax_rule_stats_t) of the rules from before
+ * @now: list to get the current stats of the rules into
+ */
+static void disable_slow_rules(hlworker_t *w, file_syntax_rules_t *rules, dlist_t *before,
+			       dlist_t *now)
+{
+	syntax_rule_stats_t *b, *n;
+	bool disabled = false;
+
+	get_syntax_rules_stats(rules, now, NULL);
+	for (int i = 0; i < now->len; ++i) {
+		b = dlist_get_address(before, i);
+		n = dlist_get_address(now, i);
+		if (!n->disabled && n->nsec-b->nsec > HLRULE_MAX_NSEC) {
+			disable_syntax_rule(rules, i);
+			disabled = true;
+		}
+	}
+	if (!disabled)
+		return;
+	pthread_mutex_lock(&w->lock);
+	cache_clear(w);
+	++w->rules_gen;
+	pthread_mutex_unlock(&w->lock);
+}
+
+/*
+ * Highlight the lines of a request, caching each as it's done. Stops early if a newer
+ * request is submitted, since the lines it needs are likely to have changed.
+ */
+static void run_request(hlworker_t *w, hlreq_t *r)
+{
+	hlstate_t state = r->state;
+	regmatch_data_t *span;
+	hlreq_line_t *rl;
+	hlline_t hl;
+	dlist_t before, now;
+
+	dlist_init(&before, DLIST_MIN_CAP, sizeof(syntax_rule_stats_t));
+	dlist_init(&now, DLIST_MIN_CAP, sizeof(syntax_rule_stats_t));
+	get_syntax_rules_stats(r->rules, &before, NULL);
+
+	for (int i = 0; i < r->lines.len; ++i) {
+		rl = dlist_get_address(&r->lines, i);
+		hl.rules = r->rules;
+		hl.start_state = state;
+		hl.first_col = rl->first_col;
+		hl.end_col = rl->end_col;
+		dlist_init(&hl.spans, DLIST_MIN_CAP, sizeof(regmatch_data_t));
+		hl.end_state = exec_syntax_rules_line(r->text.array+rl->start, rl->len, r->rules,
+						      rl->col ? 0 : state, &hl.spans);
+		if (!rl->whole)
+			hl.end_state = state;
+		for (int j = 0; j < hl.spans.len; ++j) {
+			span = dlist_get_address(&hl.spans, j);
+			span->start += rl->col;
+			span->end += rl->col;
+		}
+		state = hl.end_state;
+
+		pthread_mutex_lock(&w->lock);
+		cache_put(w, rl->version, &hl);
+		if (w->pending) {
+			pthread_mutex_unlock(&w->lock);
+			break;
+		}
+		pthread_mutex_unlock(&w->lock);
+		disable_slow_rules(w, r->rules, &before, &now);
+	}
+	dlist_free(&before, NULL);
+	dlist_free(&now, NULL);
+}
+
+static void *worker_start(hlworker_t *w)
+{
+	hlreq_t r;
+
+	hlreq_init(&r);
+	pthread_mutex_lock(&w->lock);
+	while (!w->stop) {
+		if (!w->pending) {
+			pthread_cond_wait(&w->submitted, &w->lock);
+			continue;
+		}
+		// Swap the request out so that the next one can be submitted while highlighting.
+		hlreq_t tmp = r;
+		r = w->req;
+		w->req = tmp;
+		w->pending = false;
+		w->busy_rules = r.rules;
+		w->busy_version = ((hlreq_line_t *)r.lines.array)->version;
+		w->busy_state = r.state;
+		pthread_mutex_unlock(&w->lock);
+
+		run_request(w, &r);
+		redraw_request();
+
+		pthread_mutex_lock(&w->lock);
+		w->busy_rules = NULL;
+	}
+	pthread_mutex_unlock(&w->lock);
+	hlreq_free(&r);
+	return NULL;
+}
+
+void hlworker_init(hlworker_t *w)
+{
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->submitted, NULL);
+	hmap_init(&w->cache, HMAP_MIN_CAP, sizeof(hlline_t));
+	w->lru_head = 0;
+	w->lru_tail = 0;
+	w->cache_bytes = 0;
+	w->rules_gen = 0;
+	hlreq_init(&w->req);
+	w->pending = false;
+	w->busy_rules = NULL;
+	w->stop = false;
+	pthread_create(&w->thread, NULL, (void *(*)(void *))worker_start, w);
+}
+
+void hlworker_free(hlworker_t *w)
+{
+	pthread_mutex_lock(&w->lock);
+	w->stop = true;
+	pthread_cond_signal(&w->submitted);
+	pthread_mutex_unlock(&w->lock);
+
+	pthread_join(w->thread, NULL);
+	hmap_free(&w->cache, (dlist_elem_fn)hlline_free);
+	hlreq_free(&w->req);
+	pthread_cond_destroy(&w->submitted);
+	pthread_mutex_destroy(&w->lock);
+}
+
+void hlworker_lock(hlworker_t *w)
+{
+	pthread_mutex_lock(&w->lock);
+}
+
+void hlworker_unlock(hlworker_t *w)
+{
+	pthread_mutex_unlock(&w->lock);
+}
+
+hlline_t *hlworker_get(hlworker_t *w, unsigned long version)
+{
+	hlline_t *hl = hmap_get(&w->cache, version);
+
+	if (hl && w->lru_head != version) {
+		lru_unlink(w, hl);
+		lru_push(w, version, hl);
+	}
+	return hl;
+}
+
+void hlworker_window(int len, view_t *v, int *out_first_col, int *out_end_col)
+{
+	int first_col = v->lines_first_col, end_col = first_col+view_width(v);
+
+	if (len <= HLLINE_MAX_COLS) {
+		*out_first_col = 0;
+		*out_end_col = len;
+		return;
+	}
+	*out_first_col = first_col > HLLINE_SLACK ? first_col-HLLINE_SLACK : 0;
+	*out_end_col = end_col+HLLINE_SLACK < len ? end_col+HLLINE_SLACK : len;
+}
+
+bool hlworker_covers(hlline_t *hl, int len, view_t *v)
+{
+	int first_col = v->lines_first_col < len ? v->lines_first_col : len;
+	int end_col = first_col+view_width(v) < len ? first_col+view_width(v) : len;
+
+	return first_col == end_col || (hl->first_col <= first_col && end_col <= hl->end_col);
+}
+
+void hlworker_submit(hlworker_t *w, fbuf_t *f, int row, int nrows, file_syntax_rules_t *rules,
+		     hlstate_t state)
+{
+	unsigned long version = fbuf_line_version(f, row);
+
+	if (w->busy_rules == rules && w->busy_version == version && w->busy_state == state)
+		return;
+	if (nrows > HLREQ_MAX_LINES)
+		nrows = HLREQ_MAX_LINES;
+
+	hlreq_clear(&w->req);
+	w->req.rules = rules;
+	w->req.state = state;
+	for (int i = row; i < row+nrows; ++i)
+		hlreq_add_line(&w->req, dlist_get_address(&f->lines, i), fbuf_line_version(f, i),
+			       &f->view);
+	w->pending = true;
+	pthread_cond_signal(&w->submitted);
+}
@@ -0,0 +1,167 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ * Highlight worker. A thread of its own highlights lines so that the display thread
+ * never runs the syntax rules while holding the lock on the buffers. The display thread
+ * submits a copy of the lines it needs highlighted and paints from the highlighting
+ * cached so far, and the worker requests a redraw once it has highlighted them.
+ * Being the only thread running the syntax rules, the worker also owns the scanners they
+ * are compiled into, which grow as they're run (see dfa.h).
+ *
+ * Copyright (C) 2022 Petar Turukalo
+ */
+#ifndef HLWORKER_H
+#define HLWORKER_H
+
+#include <pthread.h>
+#include "../ds/hmap.h"
+#include "../ds/str.h"
+#include "../fbuf/fbuf.h"
+#include "rule.h"
+
+// Most bytes the highlighting cache of every file buffer takes, after which the least recently
+// used lines are evicted. Well over what the lines of a request take, as the states lines start
+// in are found from the cached highlighting of the lines before them.
+#define HLCACHE_MAX_BYTES (32 << 20)
+// Most lines in a request, so that far off lines are highlighted a chunk at a time with a
+// redraw after each.
+#define HLREQ_MAX_LINES 4096
+// Most nanoseconds a rule can spend highlighting the lines of a request before it's disabled
+// for being too slow (see disable_syntax_rule()), so that a bad pattern can't keep the
+// highlighting of a file from ever catching up.
+#define HLRULE_MAX_NSEC 250000000UL
+// Lines longer than this are only highlighted in a window of columns around the view, so
+// that the cost of highlighting them depends on the size of the screen rather than theirs.
+#define HLLINE_MAX_COLS 4096
+// Columns either side of the view in the window of a long line, so that scrolling a little
+// sideways doesn't have it highlighted again.
+#define HLLINE_SLACK 1024
+// Columns scanned either side of the window of a long line, to find matches crossing its edges.
+#define HLLINE_LOOKAROUND 256
+
+/*
+ * Highlighting of a line, cached by the version of the line (see fbuf struct) so that a
+ * line is only highlighted again once it's edited or the state it starts in changes.
+ *
+ * A line longer than HLLINE_MAX_COLS is only highlighted in a window of columns. The scan of
+ * the window starts outside any region unless it starts at the start of the line, and the
+ * line is taken to end in the state it starts in, as finding either would mean scanning the
+ * whole line.
+ */
+typedef struct hlline {
+	file_syntax_rules_t *rules;  // Rules the line was highlighted with.
+	hlstate_t start_state;  // State the line started in.
+	hlstate_t end_state;  // State the line ended in.
+	int first_col, end_col;  // Window of columns highlighted, the whole line if it isn't long.
+	dlist_t spans;  // regmatch_data_t of the substrings of the line to colour, in order.
+	// Versions of the lines used just before and after in the cache's LRU list, 0 for none.
+	unsigned long lru_prev, lru_next;
+	size_t size;  // Bytes the highlighting takes in the cache.
+} hlline_t;
+
+/*
+ * Part of a line in a request.
+ */
+typedef struct hlreq_line {
+	unsigned long version;
+	int start, len;  // Index in the text of the request and length of the part.
+	int col;  // Column of the line the part starts at.
+	int first_col, end_col;  // Window of columns to highlight, see hlline_t.
+	bool whole;  // Whether the window is the whole line.
+} hlreq_line_t;
+
+/*
+ * Copy of consecutive lines of a file buffer to highlight.
+ */
+typedef struct hlreq {
+	file_syntax_rules_t *rules;
+	hlstate_t state;  // State the first line starts in.
+	str_t text;  // Text of the part of each line to scan, one after the other.
+	dlist_t lines;  // hlreq_line_t of each line.
+} hlreq_t;
+
+typedef struct hlworker {
+	pthread_t thread;
+	// Lock which must be acquired before accessing the fields below.
+	pthread_mutex_t lock;
+	pthread_cond_t submitted;  // Signalled when a request is submitted or the worker is stopping.
+	// hlline_t of lines by line version. Being unique across file buffers, the versions let
+	// the highlighting of every file buffer share the cache, so that switching back to one
+	// doesn't highlight it again.
+	hmap_t cache;
+	// Versions of the most and least recently used lines in the cache, 0 if it's empty.
+	unsigned long lru_head, lru_tail;
+	size_t cache_bytes;  // Bytes the lines in the cache take.
+	// Generation of the syntax rules, changed whenever a rule is disabled so that the states
+	// lines start in found before are found again (see fbuf struct).
+	unsigned long rules_gen;
+	hlreq_t req;  // Request waiting to be taken by the worker.
+	bool pending;  // Whether req is waiting.
+	// Rules, version of the first line and state it starts in of the request being
+	// highlighted, busy_rules NULL if there is none.
+	file_syntax_rules_t *busy_rules;
+	unsigned long busy_version;
+	hlstate_t busy_state;
+	bool stop;  // Whether the worker should exit.
+} hlworker_t;
+
+/*
+ * hlworker_init - Initialise a highlight worker and start its thread
+ *
+ * Free with hlworker_free().
+ */
+void hlworker_init(hlworker_t *w);
+
+/*
+ * hlworker_free - Stop and join the thread of a highlight worker, then free it
+ */
+void hlworker_free(hlworker_t *w);
+
+/*
+ * hlworker_lock - Acquire the lock on a highlight worker's cache and requests
+ */
+void hlworker_lock(hlworker_t *w);
+
+/*
+ * hlworker_unlock - Release the lock on a highlight worker's cache and requests
+ */
+void hlworker_unlock(hlworker_t *w);
+
+/*
+ * hlworker_get - Get the cached highlighting of a line version, NULL if it isn't cached
+ *
+ * The line becomes the most recently used in the cache, the last to be evicted. Requires
+ * the lock to be held, and the highlighting is only valid until it's released.
+ */
+hlline_t *hlworker_get(hlworker_t *w, unsigned long version);
+
+/*
+ * hlworker_window - Get the window of columns of a line to highlight for a view of it
+ * @len: length of the line
+ * @out_first_col: out-param first column of the window
+ * @out_end_col: out-param end (exclusive) column of the window
+ */
+void hlworker_window(int len, view_t *v, int *out_first_col, int *out_end_col);
+
+/*
+ * hlworker_covers - Get whether highlighting of a line covers what's in view of it
+ * @len: length of the line
+ */
+bool hlworker_covers(hlline_t *hl, int len, view_t *v);
+
+/*
+ * hlworker_submit - Submit lines of a file buffer to be highlighted, replacing any request
+ *	that hasn't been taken yet
+ * @row: row of the first line
+ * @nrows: number of lines, at most HLREQ_MAX_LINES are taken
+ * @state: state the first line starts in
+ *
+ * Long lines are highlighted in the window of their columns around the view of the file
+ * buffer (see hlworker_window()).
+ * Nothing is submitted if the worker is already highlighting from the same line in the same
+ * state. Requires the lock to be held, as well as the lines not changing during the call.
+ */
+void hlworker_submit(hlworker_t *w, fbuf_t *f, int row, int nrows, file_syntax_rules_t *rules,
+		     hlstate_t state);
+
+#endif
@@ -4,9 +4,15 @@
  * Copyright (C) 2022 Petar Turukalo
  */
 #include <stddef.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
 #include "rule.h"
 #include "../misc.h"
 #include "../log.h"
+#include "../tab.h"
 
 // Unsigned and long integer suffixes.
 #define INT_SUF_PAT "([uU][lL]{0,2}|[lL]{0,2}[uU]?)"
@@ -26,7 +32,7 @@ static syntax_rule_t c_syntax_rules[] = {
 	{ "preproc", COLOUR_MAGENTA, REG_NEWLINE, "^\\s*#\\s*(define|elif|else|endif|error|if|"
 							     "ifdef|ifndef|include|pragma|undef)\\b" },
 	{ "singleline comment", COLOUR_BLUE, REG_NEWLINE, "//.*$" },
-	{ "multiline comment", COLOUR_BLUE, 0, "/\\*(\\*[^/]|[^\\*]/|[^\\*/])*\\*/" },
+	{ "multiline comment", COLOUR_BLUE, 0, "/\\*", "\\*/" },
 	{ "string", COLOUR_RED, REG_NEWLINE, "\"(\\\\.|[^\"])*\"" },
 	{ "char", COLOUR_RED, 0, "'([^'?\\]|\\\\([abfnrtv\\'?0]|[0-3]?[0-7]{0,2}|x" HEX_PAT "{1,2}))'" },
 	{ "number", COLOUR_RED, 0, "\\b(" INT_PAT "|" FLT_PAT "|" BOOL_PAT "|NULL)\\b" },
@@ -37,101 +43,564 @@ static file_syntax_rules_t all_file_syntax_rules[] = {
 	{ c_syntax_rules, { ".c", ".h", NULL } }
 };
 
+// Rules (file_syntax_rules_t *) loaded from syntax definition files, which are found before
+// the built-in ones above.
+static dlist_t loaded_file_syntax_rules;
+
+// Lock on the stats of every rule, held while a line is highlighted.
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
 
 /*
- * Run a function on all syntax rules in the "tree" rooted at all_file_syntax_rules.
+ * Compile a pattern of a syntax rule into a scanner, logging any error.
+ * Return whether it compiled.
  */
-static void for_each_syntax_rule(void (*fn)(syntax_rule_t *))
+static bool compile_syntax_pattern(syntax_rule_t *rule, dfa_t *d, char *pattern)
 {
-	file_syntax_rules_t *frules = all_file_syntax_rules;
-	int m, n = ARRAY_LEN(all_file_syntax_rules);
-	syntax_rule_t *rule;
+	char errbuf[64];
 
-	for (int i = 0; i < n; ++i) {
-		m = array_len((char *)frules[i].rules, sizeof(syntax_rule_t));
-		rule = frules[i].rules;
-		for (int j = 0; j < m; ++j, ++rule) 
-			fn(rule);
+	if (!dfa_add(d, pattern, rule->cflags, errbuf, sizeof(errbuf))) {
+		tlog("failed to compile regex %s: %s", rule->type, errbuf);
+		return false;
 	}
+	return true;
+}
+
+/*
+ * Initialise a scanner for syntax rules, which scans the pseudo spaces of lines (see tab.h)
+ * as spaces so that lines can be scanned as they're stored.
+ */
+static void syntax_dfa_init(dfa_t *d)
+{
+	dfa_init(d);
+	dfa_alias(d, TAB_START, ' ');
+	dfa_alias(d, TAB_CONT, ' ');
 }
 
-static void compile_syntax_rule(syntax_rule_t *rule) 
+/*
+ * Compile a syntax rule into the scanner of the rules of its file type, along with the scanner
+ * of the end of its region if it's a region rule.
+ */
+static void compile_syntax_rule(file_syntax_rules_t *frules, syntax_rule_t *rule)
 {
-	int errcode = regcomp(&rule->regex, rule->regex_pattern, REG_EXTENDED|rule->cflags);
+	rule->compiled = compile_syntax_pattern(rule, &frules->dfa, rule->regex_pattern);
+	if (rule->end_pattern) {
+		syntax_dfa_init(&rule->end_dfa);
+		if (!compile_syntax_pattern(rule, &rule->end_dfa, rule->end_pattern))
+			rule->compiled = false;
+	}
+}
 
-	rule->compiled = !errcode;
+/*
+ * Get the path of the compiled cache of a syntax definition file. Free with free().
+ */
+static char *syntax_cache_path(file_syntax_rules_t *frules)
+{
+	char *path = malloc(strlen(frules->path)+sizeof(SYNTAX_CACHE_EXT));
 
-	if (errcode) {
-		char errbuf[64];
-		regerror(errcode, &rule->regex, errbuf, sizeof(errbuf));
-		tlog("failed to compile regex %s, error code %d: %s", rule->type, errcode, errbuf);
-	} 
+	sprintf(path, "%s" SYNTAX_CACHE_EXT, frules->path);
+	return path;
 }
 
-void compile_syntax_rules(void)
+/*
+ * Header of the compiled cache of a syntax definition file, identifying the version of the
+ * file it was compiled from.
+ */
+struct syntax_cache_header {
+	char magic[8];
+	long long size;  // Size of the definition file.
+	long long mtime;  // Modification time of the definition file.
+	int nrules;
+};
+
+/*
+ * Get the header the compiled cache of a syntax definition file should have.
+ * Return false if the definition file can't be found.
+ */
+static bool syntax_cache_header(file_syntax_rules_t *frules, struct syntax_cache_header *out_h)
 {
-	for_each_syntax_rule(compile_syntax_rule);
+	struct stat st;
+
+	if (stat(frules->path, &st) == -1)
+		return false;
+	memset(out_h, 0, sizeof(*out_h));
+	memcpy(out_h->magic, SYNTAX_CACHE_MAGIC, sizeof(out_h->magic));
+	out_h->size = st.st_size;
+	out_h->mtime = st.st_mtime;
+	out_h->nrules = array_len((char *)frules->rules, sizeof(syntax_rule_t));
+	return true;
 }
 
-static void free_syntax_rule(syntax_rule_t *rule)
+/*
+ * Read the scanners of syntax rules loaded from a definition file from its compiled cache.
+ * Return false if there's no cache of the file as it is now, leaving the rules uncompiled.
+ */
+static bool read_syntax_cache(file_syntax_rules_t *frules)
 {
-	regfree(&rule->regex);
+	struct syntax_cache_header want, got;
+	char *path = syntax_cache_path(frules);
+	FILE *fp = fopen(path, "rb");
+	syntax_rule_t *rule;
+	bool ok;
+
+	free(path);
+	if (!fp)
+		return false;
+	ok = syntax_cache_header(frules, &want) && fread(&got, sizeof(got), 1, fp) == 1 &&
+	     !memcmp(&want, &got, sizeof(want));
+
+	syntax_dfa_init(&frules->dfa);
+	for (rule = frules->rules; rule->type; ++rule) {
+		if (rule->end_pattern)
+			syntax_dfa_init(&rule->end_dfa);
+	}
+	ok = ok && dfa_read(&frules->dfa, fp);
+	for (rule = frules->rules; ok && rule->type; ++rule) {
+		ok = fread(&rule->compiled, sizeof(bool), 1, fp) == 1;
+		if (ok && rule->end_pattern)
+			ok = dfa_read(&rule->end_dfa, fp);
+	}
+	fclose(fp);
+
+	if (!ok) {
+		dfa_free(&frules->dfa);
+		for (rule = frules->rules; rule->type; ++rule) {
+			if (rule->end_pattern)
+				dfa_free(&rule->end_dfa);
+		}
+	}
+	return ok;
 }
 
-void free_syntax_rules(void)
+/*
+ * Write the scanners of syntax rules loaded from a definition file to its compiled cache.
+ */
+static void write_syntax_cache(file_syntax_rules_t *frules)
 {
-	for_each_syntax_rule(free_syntax_rule);
+	struct syntax_cache_header h;
+	char *path = syntax_cache_path(frules);
+	FILE *fp = NULL;
+	syntax_rule_t *rule;
+	bool ok;
+
+	ok = syntax_cache_header(frules, &h) && (fp = fopen(path, "wb")) &&
+	     fwrite(&h, sizeof(h), 1, fp) == 1 && dfa_write(&frules->dfa, fp);
+	for (rule = frules->rules; ok && rule->type; ++rule) {
+		ok = fwrite(&rule->compiled, sizeof(bool), 1, fp) == 1;
+		if (ok && rule->end_pattern)
+			ok = dfa_write(&rule->end_dfa, fp);
+	}
+	if (fp && fclose(fp))
+		ok = false;
+	// A partly written cache would only be rejected when read, but don't leave it about.
+	if (fp && !ok)
+		remove(path);
+	if (!ok)
+		tlog("failed to write syntax cache %s", path);
+	free(path);
 }
 
+/*
+ * Compile the rules of a file type, from the compiled cache of their definition file if they
+ * were loaded from one and it's up to date.
+ */
+static void compile_file_syntax_rules(file_syntax_rules_t *frules)
+{
+	syntax_rule_t *rule;
+
+	frules->compiled = true;
+	if (frules->path && read_syntax_cache(frules))
+		return;
+	syntax_dfa_init(&frules->dfa);
+	for (rule = frules->rules; rule->type; ++rule)
+		compile_syntax_rule(frules, rule);
+	if (frules->path)
+		write_syntax_cache(frules);
+}
 
-syntax_rule_t *find_syntax_rules(char *file)
+/*
+ * Get the colour pair with a name, such as "red", 0 if there's no such colour.
+ */
+static clrpair_t colour_of(char *name)
 {
-	file_syntax_rules_t *frules = all_file_syntax_rules;
-	int n = ARRAY_LEN(all_file_syntax_rules);
-	char **ext;
+	static char *names[] = {
+		"default", "black", "red", "green", "yellow", "blue", "magenta", "cyan", "white"
+	};
 
-	for (int i = 0; i < n; ++i) {
-		ext = frules[i].file_extensions;
-		for (; *ext; ++ext) {
-			if (strcmp_suffix(file, *ext))
-				return frules[i].rules;
+	for (int i = 0; i < ARRAY_LEN(names); ++i) {
+		if (!strcmp(name, names[i]))
+			return COLOUR_DEFAULT+i;
+	}
+	return 0;
+}
+
+/*
+ * Take the next word separated by blanks from a line of a syntax definition file.
+ * @p: in-out param position in the line, moved past the word and the blanks after it
+ *
+ * Return the word, null-terminated in place.
+ */
+static char *take_word(char **p)
+{
+	char *word = *p;
+
+	*p += strcspn(*p, " \t");
+	if (**p)
+		*(*p)++ = '\0';
+	*p += strspn(*p, " \t");
+	return word;
+}
+
+/*
+ * Parse the colour field "colour[,flag]..." of a rule of a syntax definition file, where the
+ * flags are "icase" and "newline".
+ * Return false if the colour or a flag isn't known.
+ */
+static bool parse_colour_field(char *field, syntax_rule_t *rule)
+{
+	char *flag = strchr(field, ',');
+
+	if (flag)
+		*flag++ = '\0';
+	if (!(rule->clrpair = colour_of(field)))
+		return false;
+	rule->cflags = 0;
+	for (char *f = flag; f; f = flag) {
+		if ((flag = strchr(f, ',')))
+			*flag++ = '\0';
+		if (!strcmp(f, "icase"))
+			rule->cflags |= REG_ICASE;
+		else if (!strcmp(f, "newline"))
+			rule->cflags |= REG_NEWLINE;
+		else
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Parse a line of a syntax definition file into the rules being loaded.
+ * @rules: list of syntax_rule_t loaded so far
+ * @next_ext: in-out param number of file extensions loaded so far
+ *
+ * Return an error message if the line is invalid, otherwise NULL.
+ */
+static char *parse_syntax_line(char *line, file_syntax_rules_t *frules, dlist_t *rules,
+			       int *next_ext)
+{
+	syntax_rule_t rule = { 0 }, *last;
+	char *p = line+strspn(line, " \t");
+	char *keyword;
+
+	if (!*p || *p == '#')
+		return NULL;
+	keyword = take_word(&p);
+
+	if (!strcmp(keyword, "ext")) {
+		while (*p) {
+			if (*next_ext == NFILE_EXT-1)
+				return "too many file extensions";
+			frules->file_extensions[(*next_ext)++] = strdup(take_word(&p));
 		}
+	} else if (!strcmp(keyword, "rule")) {
+		rule.type = take_word(&p);
+		if (!*p || !parse_colour_field(take_word(&p), &rule))
+			return "bad colour";
+		if (!*p)
+			return "missing pattern";
+		rule.type = strdup(rule.type);
+		rule.regex_pattern = strdup(p);
+		dlist_append(rules, &rule);
+	} else if (!strcmp(keyword, "end")) {
+		last = rules->len ? dlist_get_address(rules, rules->len-1) : NULL;
+		if (!last || last->end_pattern)
+			return "end without a rule";
+		if (!*p)
+			return "missing pattern";
+		last->end_pattern = strdup(p);
+	} else {
+		return "unknown keyword";
 	}
 	return NULL;
 }
 
+static void free_loaded_rule(syntax_rule_t *rule)
+{
+	free(rule->type);
+	free(rule->regex_pattern);
+	free(rule->end_pattern);
+}
+
 /*
- * For two pointers p and q where p < q, make on offset from q relative to p.
+ * Load the rules of a syntax definition file, without compiling them. Invalid lines are
+ * logged and skipped.
+ * Return the rules, or NULL if the file couldn't be read or has no rules or file extensions.
  */
-static int ptr_relative_off(char *p, char *q, off_t off)
+static file_syntax_rules_t *load_syntax_file(char *path)
 {
-	return (q-p)+off;
+	file_syntax_rules_t *frules = calloc(1, sizeof(file_syntax_rules_t));
+	FILE *fp = fopen(path, "r");
+	syntax_rule_t end = { 0 };
+	char *line = NULL, *err;
+	size_t cap = 0;
+	int lnr = 0, next_ext = 0;
+	dlist_t rules;
+
+	if (!fp) {
+		free(frules);
+		return NULL;
+	}
+	dlist_init(&rules, DLIST_MIN_CAP, sizeof(syntax_rule_t));
+	while (getline(&line, &cap, fp) != -1) {
+		++lnr;
+		strip_trailchar(line, '\n');
+		if ((err = parse_syntax_line(line, frules, &rules, &next_ext)))
+			tlog("%s:%d: %s", path, lnr, err);
+	}
+	free(line);
+	fclose(fp);
+
+	if (!rules.len || !next_ext) {
+		tlog("%s: no rules or file extensions", path);
+		dlist_free(&rules, (dlist_elem_fn)free_loaded_rule);
+		for (int i = 0; i < next_ext; ++i)
+			free(frules->file_extensions[i]);
+		free(frules);
+		return NULL;
+	}
+	dlist_append(&rules, &end);  // Rules are terminated by an empty rule.
+	frules->rules = (syntax_rule_t *)rules.array;  // The rules now belong to frules.
+	frules->path = strdup(path);
+	return frules;
+}
+
+static int is_syntax_file(const struct dirent *e)
+{
+	return strcmp_suffix((char *)e->d_name, SYNTAX_FILE_EXT);
+}
+
+void load_syntax_rules(void)
+{
+	char *home = getenv("HOME"), *path;
+	file_syntax_rules_t *frules;
+	struct dirent **entries;
+	char dir[PATH_MAX];
+	int n;
+
+	dlist_init(&loaded_file_syntax_rules, DLIST_MIN_CAP, sizeof(file_syntax_rules_t *));
+	if (!home)
+		return;
+	snprintf(dir, sizeof(dir), "%s/" SYNTAX_DIR, home);
+	if ((n = scandir(dir, &entries, is_syntax_file, alphasort)) == -1)
+		return;
+	for (int i = 0; i < n; ++i) {
+		path = malloc(strlen(dir)+strlen(entries[i]->d_name)+2);
+		sprintf(path, "%s/%s", dir, entries[i]->d_name);
+		if ((frules = load_syntax_file(path)))
+			dlist_append(&loaded_file_syntax_rules, &frules);
+		free(path);
+		free(entries[i]);
+	}
+	free(entries);
 }
 
-static void exec_syntax_rule(char *text, syntax_rule_t *rule, dlist_t *out_matches)
+/*
+ * Free the scanners of the rules of a file type, if they were compiled.
+ */
+static void free_file_syntax_dfas(file_syntax_rules_t *frules)
 {
-	regmatch_t match;
-	regmatch_data_t mdata;
-	char *s = text;
+	syntax_rule_t *rule;
 
-	if (!rule->compiled)
+	if (!frules->compiled)
 		return;
-	while (regexec(&rule->regex, s, 1, &match, 0) != REG_NOMATCH) {
-		// The indices in match are relative to s. Make them relative to the original text.
-		mdata.start = ptr_relative_off(text, s, match.rm_so);
-		mdata.end = ptr_relative_off(text, s, match.rm_eo);
-		mdata.clrpair = rule->clrpair;
+	dfa_free(&frules->dfa);
+	for (rule = frules->rules; rule->type; ++rule) {
+		if (rule->end_pattern)
+			dfa_free(&rule->end_dfa);
+	}
+}
+
+static void free_loaded_file_syntax_rules(file_syntax_rules_t **frules)
+{
+	syntax_rule_t *rule;
+
+	free_file_syntax_dfas(*frules);
+	for (rule = (*frules)->rules; rule->type; ++rule)
+		free_loaded_rule(rule);
+	for (char **ext = (*frules)->file_extensions; *ext; ++ext)
+		free(*ext);
+	free((*frules)->rules);
+	free((*frules)->path);
+	free(*frules);
+}
+
+void free_syntax_rules(void)
+{
+	int n = ARRAY_LEN(all_file_syntax_rules);
+
+	for (int i = 0; i < n; ++i)
+		free_file_syntax_dfas(all_file_syntax_rules+i);
+	dlist_free(&loaded_file_syntax_rules, (dlist_elem_fn)free_loaded_file_syntax_rules);
+}
+
+/*
+ * Get whether the rules of a file type are for a file, by its extension.
+ */
+static bool syntax_rules_match(file_syntax_rules_t *frules, char *file)
+{
+	for (char **ext = frules->file_extensions; *ext; ++ext) {
+		if (strcmp_suffix(file, *ext))
+			return true;
+	}
+	return false;
+}
+
+file_syntax_rules_t *find_syntax_rules(char *file)
+{
+	int n = ARRAY_LEN(all_file_syntax_rules);
+	file_syntax_rules_t *frules = NULL;
+
+	for (int i = 0; i < loaded_file_syntax_rules.len && !frules; ++i) {
+		dlist_get(&loaded_file_syntax_rules, i, &frules);
+		if (!syntax_rules_match(frules, file))
+			frules = NULL;
+	}
+	for (int i = 0; i < n && !frules; ++i) {
+		if (syntax_rules_match(all_file_syntax_rules+i, file))
+			frules = all_file_syntax_rules+i;
+	}
+	if (frules && !frules->compiled)
+		compile_file_syntax_rules(frules);
+	return frules;
+}
+
+/*
+ * Add a span of text to colour.
+ */
+static void add_span(dlist_t *out_spans, int start, int end, clrpair_t clrpair)
+{
+	regmatch_data_t span = { start, end, clrpair };
+
+	if (end > start)
+		dlist_append(out_spans, &span);
+}
+
+/*
+ * Find the end of the region of a region rule in text from an index.
+ * Return the end of the match of the rule's end pattern, or -1 if the region carries on
+ * past the text.
+ */
+static int region_end(syntax_rule_t *rule, char *text, int len, int from)
+{
+	int start, end;
+
+	if (dfa_search(&rule->end_dfa, text, len, from, &start, &end) == -1)
+		return -1;
+	return end;
+}
 
-		dlist_append(out_matches, &mdata);
-		// Move to the char immediately after the substring just matched.
-		s += match.rm_eo;
+/*
+ * Get the current time of a monotonic clock in nanoseconds.
+ */
+static unsigned long nsec_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1000000000UL+ts.tv_nsec;
+}
+
+/*
+ * Count a match of a rule in its stats, the time since the clock was last read being spent
+ * on it. Requires the stats lock to be held.
+ * @since: in/out-param time the clock was last read
+ */
+static void count_match(syntax_rule_t *rule, int start, int end, unsigned long *since)
+{
+	unsigned long now = nsec_now();
+
+	++rule->stats.matches;
+	rule->stats.bytes += end-start;
+	rule->stats.nsec += now-*since;
+	*since = now;
+}
+
+hlstate_t exec_syntax_rules_line(char *text, int len, file_syntax_rules_t *frules,
+				 hlstate_t state, dlist_t *out_spans)
+{
+	syntax_rule_t *rules = frules->rules, *rule;
+	int pos = 0;
+	int r, end;
+	unsigned long since, now;
+
+	// The clock is only read around matches, as reading it per byte would cost more than
+	// the scan.
+	pthread_mutex_lock(&stats_lock);
+	since = nsec_now();
+
+	// Finish off a region carried over from the lines before.
+	if (state) {
+		rule = rules+state-1;
+		if ((end = region_end(rule, text, len, 0)) == -1)
+			end = len;
+		else
+			state = 0;
+		add_span(out_spans, 0, end, rule->clrpair);
+		count_match(rule, 0, end, &since);
+		pos = end;
 	}
+
+	while (pos < len) {
+		r = dfa_match(&frules->dfa, text, len, pos, &end);
+		// An empty match colours nothing, so the scan moves on as if nothing matched.
+		if (r == -1 || end == pos || !rules[r].compiled) {
+			++pos;
+			continue;
+		}
+		// The time so far is mostly the scan of the positions where nothing matched, put
+		// down to no rule. The match is found again on its own to time it, so a rule is
+		// only charged for its own matches and never for a slow scan before them.
+		now = nsec_now();
+		frules->scan_nsec += now-since;
+		since = now;
+		dfa_match(&frules->dfa, text, len, pos, &end);
+		rule = rules+r;
+		if (rule->end_pattern && (end = region_end(rule, text, len, end)) == -1) {
+			// The region carries on to the next line.
+			end = len;
+			state = r+1;
+		}
+		add_span(out_spans, pos, end, rule->clrpair);
+		count_match(rule, pos, end, &since);
+		pos = end;
+	}
+	frules->scan_nsec += nsec_now()-since;
+	pthread_mutex_unlock(&stats_lock);
+	return state;
+}
+
+void get_syntax_rules_stats(file_syntax_rules_t *frules, dlist_t *out_stats,
+			    unsigned long *out_scan_nsec)
+{
+	syntax_rule_t *rule;
+
+	dlist_resize_len(out_stats, 0);
+	pthread_mutex_lock(&stats_lock);
+	for (rule = frules->rules; rule->type; ++rule)
+		dlist_append(out_stats, &rule->stats);
+	if (out_scan_nsec)
+		*out_scan_nsec = frules->scan_nsec;
+	pthread_mutex_unlock(&stats_lock);
 }
 
-void exec_syntax_rules(char *text, syntax_rule_t *rules, dlist_t *out_matches)
+void disable_syntax_rule(file_syntax_rules_t *frules, int r)
 {
-	int n = array_len((char *)rules, sizeof(syntax_rule_t));
+	syntax_rule_t *rule = frules->rules+r;
 
-	for (int i = 0; i < n; ++i)  
-		exec_syntax_rule(text, rules+i, out_matches);
+	dfa_disable(&frules->dfa, r);
+	pthread_mutex_lock(&stats_lock);
+	rule->stats.disabled = true;
+	pthread_mutex_unlock(&stats_lock);
+	tlog("disabled syntax rule %s for being too slow: %lu ns for %lu matches of %lu bytes",
+	     rule->type, rule->stats.nsec, rule->stats.matches, rule->stats.bytes);
 }
@@ -1,7 +1,8 @@
 /*
  * SPDX-License-Identifier: GPL-2.0
  *
- * Syntax highlighting rules using regex.
+ * Syntax highlighting rules using regex. The rules for a file type are compiled into a single
+ * scanner (see dfa.h), so that a line is highlighted in one pass over it.
  *
  * Copyright (C) 2022 Petar Turukalo
  */
@@ -12,11 +13,20 @@
 #include "colour.h"
 #include "../chrp.h"
 #include "../ds/dlist.h"
+#include "dfa.h"
 
 // Number of file type extensions that a set of syntax rules can be applied to
 // (minus 1 because the array should be NULL pointer terminated).
 #define NFILE_EXT 16
 
+// Directory in the home directory of syntax definition files, and the extension they have.
+#define SYNTAX_DIR ".tedit_syntax"
+#define SYNTAX_FILE_EXT ".syn"
+// Extension added to the path of a syntax definition file for its compiled cache, and the
+// magic number the cache starts with. The magic number changes whenever the format does.
+#define SYNTAX_CACHE_EXT ".dfa"
+#define SYNTAX_CACHE_MAGIC "tedsyn1"
+
 /*
  * Data identifying a substring matched under a syntax element.
  * @start: start index (inclusive) of substring matched relative to original string
@@ -28,56 +38,136 @@ typedef struct regex_match_data {
 	clrpair_t clrpair;
 } regmatch_data_t;
 
+/*
+ * Counts of the highlighting done by a syntax rule, to find the rules that are slow.
+ * @matches: number of matches highlighted
+ * @bytes: number of bytes highlighted, the regions of a region rule included
+ * @nsec: nanoseconds spent finding and highlighting the matches, not including scanning the
+ *	text where no rule matched, which can't be put down to any one rule
+ * @disabled: whether the rule was disabled for being too slow
+ */
+typedef struct syntax_rule_stats {
+	unsigned long matches;
+	unsigned long bytes;
+	unsigned long nsec;
+	bool disabled;
+} syntax_rule_stats_t;
+
 /*
  * A rule describing a syntax element and its associated colour.
  * @type: the type of syntax element, such as "keyword"
  * @clrpair: colour pair associated with this syntax element. Strings matching the pattern
  *	will be coloured this. See colour_pair for more info.
- * @cflags: extra cflags specific to this syntax rule passed to regcomp()
+ * @cflags: extra cflags specific to this syntax rule, REG_ICASE or REG_NEWLINE
  * @regex_pattern: regex pattern describing all the strings that fall under
  *	this syntax element, e.g. for the "keyword" syntax element, matching
  *	strings could be loop constructs "for", "while", conditional "if", etc.
- * @compiled: whether the syntax rule was successfully compiled with call to regcomp()
+ * @end_pattern: for a region rule, such as a multiline comment, regex pattern describing
+ *	the end of the region, which can be on a later line than its start described by
+ *	regex_pattern. NULL for a rule whose matches are within a line.
+ * @end_dfa: scanner of end_pattern
+ * @compiled: whether the syntax rule's patterns were successfully compiled
+ * @stats: counts of the highlighting done by the rule, see get_syntax_rules_stats()
  */
 typedef struct syntax_rule {
 	char *type;
 	clrpair_t clrpair;
 	int cflags;
 	char *regex_pattern;
-	regex_t regex;
+	char *end_pattern;
+	dfa_t end_dfa;
 	bool compiled;
+	syntax_rule_stats_t stats;
 } syntax_rule_t;
 
+/*
+ * State of highlighting at the start or end of a line: 0 outside any region, otherwise
+ * 1 plus the index of the region rule whose region the line is in.
+ */
+typedef int hlstate_t;
+
 /*
  * Association between file types and the set of syntax rules used to highlight
  * its syntax.
  * @file_extensions: list of file type extensions the rules will be applied to,
  *	e.g. ".c", ".h". This should be NULL pointer terminated.
+ * @dfa: scanner of the patterns of all the rules, each pattern having the index of its rule
+ * @path: syntax definition file the rules were loaded from, NULL for built-in rules
+ * @compiled: whether the rules have been compiled, which they are the first time they're found
+ * @scan_nsec: nanoseconds spent scanning text where no rule matched, see
+ *	get_syntax_rules_stats()
  */
 typedef struct file_syntax_rules {
 	syntax_rule_t *rules;
-	char *file_extensions[NFILE_EXT];  
+	char *file_extensions[NFILE_EXT];
+	dfa_t dfa;
+	char *path;
+	bool compiled;
+	unsigned long scan_nsec;
 } file_syntax_rules_t;
 
 
 /*
- * Compile the regex backing all syntax rules. A single call to this must be made before any subsequent
- * calls to exec_syntax_rules().
+ * Load the syntax definition files in ~/SYNTAX_DIR, in order of name, without compiling any
+ * rules. Rules are compiled when first found by find_syntax_rules(). A single call to this
+ * must be made before any calls to find_syntax_rules().
+ *
+ * A definition file ending in SYNTAX_FILE_EXT has a line per directive, blank lines and lines
+ * starting with '#' being ignored:
+ *	ext EXT...			file extensions the rules are for, such as ".py"
+ *	rule TYPE COLOUR[,FLAG]... PATTERN
+ *					rule whose pattern is the rest of the line, FLAG being
+ *					icase or newline
+ *	end PATTERN			makes the rule before a region rule ending at PATTERN
+ * A compiled cache of each file is kept next to it, used for as long as the file is unchanged.
  */
-void compile_syntax_rules(void);
-/* Free the memory allocated from compile_syntax_rules(). */
+void load_syntax_rules(void);
+/* Free the memory allocated from load_syntax_rules() and compiling the rules. */
 void free_syntax_rules(void);
 
 
 /*
- * Find the syntax rules for a file by checking its type, or NULL if there are no syntax rules 
- * supported for its file type.
+ * Find the syntax rules for a file by checking its type, or NULL if there are no syntax rules
+ * supported for its file type. Rules loaded from definition files are found before built-in
+ * ones. The rules found are compiled if they haven't been yet, so this is only meant to be
+ * called with the lock on the text editor data held (see tedata_t).
+ */
+file_syntax_rules_t *find_syntax_rules(char *file);
+
+/*
+ * Highlight a line as per the syntax rules, starting in a state carried over from the
+ * line before it.
+ * @text: text of the line without its newline, not null-terminated, with tabs as pseudo spaces
+ *	(see tab.h), which are matched as spaces
+ * @len: length of text
+ * @state: state at the start of the line, 0 for the first line
+ * @out_spans: out-param list of regmatch_data_t of the substrings to colour, in order
+ *
+ * The line is scanned from the start, and at each index the first rule matching there is
+ * applied with its longest match, the scan then carrying on after the match. Rules are only
+ * matched outside the matches of other rules, so a keyword in a string isn't coloured.
+ * The stats of the rules applied are counted (see get_syntax_rules_stats()).
+ * Return the state at the end of the line, the state the next line starts in.
+ */
+hlstate_t exec_syntax_rules_line(char *text, int len, file_syntax_rules_t *frules,
+				 hlstate_t state, dlist_t *out_spans);
+
+/*
+ * Get the counts of the highlighting done by each syntax rule of a file type so far. Unlike
+ * the other functions here, this can be called by any thread, the counts being updated a line
+ * at a time under a lock.
+ * @out_stats: out-param list of syntax_rule_stats_t of each rule, in order
+ * @out_scan_nsec: out-param nanoseconds spent scanning where no rule matched, NULL if not
+ *	needed
  */
-syntax_rule_t *find_syntax_rules(char *file);
+void get_syntax_rules_stats(file_syntax_rules_t *frules, dlist_t *out_stats,
+			    unsigned long *out_scan_nsec);
 
 /*
- * Process the text as per the syntax rules for a list of regmatch_data_t. 
+ * Disable a syntax rule of a file type for being too slow, logging a warning. It no longer
+ * matches, though a region it started carries on to its end as before.
+ * @r: index of the rule
  */
-void exec_syntax_rules(char *text, syntax_rule_t *rules, dlist_t *out_matches);
+void disable_syntax_rule(file_syntax_rules_t *frules, int r);
 
 #endif
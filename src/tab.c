@@ -137,6 +137,34 @@ void str_align_next_tab(str_t *s, int start_ind, int tabsz)
 		str_align_tab(s, tab_ind, tabsz);
 }
 
+int tab_realigned_col(char *s, int n, int col, int tabsz)
+{
+	for (int i = 0; i < n; ++i) {
+		// A tab's continuation characters are dropped and regrown from its start.
+		if (s[i] == TAB_START)
+			col += dist_to_next_tabstop(col, tabsz);
+		else if (s[i] != TAB_CONT)
+			++col;
+	}
+	return col;
+}
+
+int tab_realigned_copy(char *dest, int col, char *s, int n, int tabsz)
+{
+	int spaces;
+
+	for (int i = 0; i < n; ++i) {
+		if (s[i] == TAB_START) {
+			spaces = dist_to_next_tabstop(col, tabsz);
+			dest[col++] = TAB_START;
+			while (--spaces)
+				dest[col++] = TAB_CONT;
+		} else if (s[i] != TAB_CONT)
+			dest[col++] = s[i];
+	}
+	return col;
+}
+
 void str_replace_pspaces(str_t *s)
 {
 	strreplace(s->array, TAB_START, ' ');
@@ -84,6 +84,27 @@ void str_expand_tab_spaces(str_t *s, int tabsz);
  */
 void str_align_next_tab(str_t *s, int start_ind, int tabsz);
 
+/*
+ * tab_realigned_col - Get the column reached by placing characters at a column, with any tabs
+ *	among them realigned to the tabstops of their new position
+ * @s: characters to place, with tabs as pseudo spaces
+ * @n: number of characters in s
+ * @col: column the first character is placed at
+ *
+ * O(n) worst case time complexity.
+ */
+int tab_realigned_col(char *s, int n, int col, int tabsz);
+
+/*
+ * tab_realigned_copy - Copy characters to a column in a destination, realigning any tabs among
+ *	them to the tabstops of their new position
+ * @dest: characters to copy to, with room for up to the column returned by tab_realigned_col()
+ *
+ * See tab_realigned_col() for the other params. Return the column after the last copied character.
+ * O(n) worst case time complexity.
+ */
+int tab_realigned_copy(char *dest, int col, char *s, int n, int tabsz);
+
 /*
  * Replace all pseudo spaces in a string with actual spaces.
  */
@@ -5,6 +5,8 @@
  */
 #include "tedata.h"
 #include "log.h"
+#include "redraw.h"
+#include "getch.h"
 
 void setup_curses(void)
 {
@@ -12,6 +14,7 @@ void setup_curses(void)
 	noecho();
 	keypad(stdscr, true);
 	set_escdelay(20);  // (Milliseconds.)
+	getch_set_paste(true);
 }
 
 static void init_syntax_highlighting(tedata_t *t)
@@ -22,14 +25,20 @@ static void init_syntax_highlighting(tedata_t *t)
 	}
 	start_color();
 	init_pairs();
-	compile_syntax_rules();
+	load_syntax_rules();
 	clrmap_init(&t->clrmap, t->win);
 }
 
 bool tedata_init(tedata_t *t, char *fpaths[])
 {
-	if (sem_init(&t->sem, 0, 1) == -1) {
-		tlog("failed to init semaphore");
+	if (sem_init(&t->sem, 0, 1) == -1 || sem_init(&t->draw_sem, 0, 1) == -1) {
+		tlog("failed to init semaphores");
+		return false;
+	}
+	if (!redraw_init()) {
+		tlog("failed to init redraw requests");
+		sem_destroy(&t->sem);
+		sem_destroy(&t->draw_sem);
 		return false;
 	}
 
@@ -39,7 +48,9 @@ bool tedata_init(tedata_t *t, char *fpaths[])
 	// out if the display window is the same as the get character input window.
 	if (!initscr()) {
 		tlog("failed to init curses");
+		redraw_free();
 		sem_destroy(&t->sem);
+		sem_destroy(&t->draw_sem);
 		return false;
 	}
 	refresh();  // Refresh once so that the first call to getch doesn't refresh.
@@ -47,14 +58,18 @@ bool tedata_init(tedata_t *t, char *fpaths[])
 
 	if (!t->win) {
 		tlog("failed to create new curses window");
+		redraw_free();
 		sem_destroy(&t->sem);
+		sem_destroy(&t->draw_sem);
 		endwin();
 		return false;
 	}
 	init_syntax_highlighting(t);
 	setup_curses();
 	bufs_init(&t->bufs, t->win, fpaths);
+	t->bufs.lock = &t->sem;
 	cmds_init(&t->cmds);
+	snapshots_init(&t->snaps);
 
 	return true;
 }
@@ -62,18 +77,26 @@ bool tedata_init(tedata_t *t, char *fpaths[])
 static void free_syntax_highlighting(tedata_t *t)
 {
 	if (has_colors()) {
-		free_syntax_rules();
+		// The highlight worker is stopped first, as it runs the syntax rules.
 		clrmap_free(&t->clrmap);
+		free_syntax_rules();
 	}
 }
 
 void tedata_free(tedata_t *t)
 {
+	// Taken for good, so that the display finishes any frame it's drawing and draws no more.
+	sem_wait(&t->draw_sem);
+	// Freed first so that the highlight worker no longer requests redraws.
+	free_syntax_highlighting(t);
 	delwin(t->win);
+	getch_set_paste(false);
 	endwin();
 	sem_destroy(&t->sem);
+	sem_destroy(&t->draw_sem);
+	redraw_free();
+	snapshots_free(&t->snaps);
 	bufs_free(&t->bufs);
 	cmds_free(&t->cmds);
-	free_syntax_highlighting(t);
 }
 
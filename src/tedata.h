@@ -15,15 +15,19 @@
 #include "fbuf/bufs.h"
 #include "cmd/cmd.h"
 #include "synhl/clrmap.h"
+#include "snapshot.h"
 
 struct text_editor_data {
 	WINDOW *win;  // Curses window for displaying file buffers in.
 	bufs_t bufs;
 	cmds_t cmds;
 	clrmap_t clrmap;
+	snapshots_t snaps;  // What the display shows, published for it to draw without sem.
 	// Lock which must be acquired before accessing other fields
 	// of this data structure.
 	sem_t sem;  
+	// Lock held while the display draws a frame, so curses isn't freed in the middle of one.
+	sem_t draw_sem;
 };
 
 typedef struct text_editor_data tedata_t;
@@ -166,7 +166,8 @@ static void view_sync_crs_row_above(view_t *v, cursor_t *c, int nlines)
 		if (v->lines_top_row < 0)
 			v->lines_top_row = 0;
 	} else
-		v->lines_top_row -= 1;
+		// Cursor could have jumped more than one row, e.g. by a command.
+		v->lines_top_row = c->row;
 }
 
 /*
@@ -177,7 +178,7 @@ static void view_sync_crs_row_below(view_t *v, cursor_t *c, int nlines)
 	if (v->pgmv) 
 		v->lines_top_row += view_height(v);
 	else 
-		v->lines_top_row += 1;
+		v->lines_top_row = c->row-view_height(v)+1;
 }
 
 /*
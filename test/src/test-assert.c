@@ -1,11 +1,25 @@
 #include "test-ds.h"
 #include "test-tab.h"
 #include "test-chrp.h"
+#include "test-dfa.h"
+#include "test-keydec.h"
+#include "test-epoch.h"
+#include "test-mcursor.h"
+#include "test-subst.h"
+#include "test-sindex.h"
+#include "test-hlstates.h"
 
 int main(void)
 {
 	test_ds();
 	test_tab();
 	test_chrp();
+	test_dfa();
+	test_keydec();
+	test_epoch();
+	test_mcursor();
+	test_subst();
+	test_sindex();
+	test_hlstates();
 	return 0;
 }
@@ -53,9 +53,47 @@ static void test_strip_trailchar(void)
 	assert_strip_trailchar(" a bb", 'b', " a ");
 }
 
+static void assert_chrp_memmem(char *s, char *t, int expected_offset)
+{
+	char *found = chrp_memmem(s, strlen(s), t, strlen(t));
+
+	if (expected_offset == -1)
+		assert(found == NULL);
+	else
+		assert(found == s+expected_offset);
+}
+
+static void test_chrp_memmem(void)
+{
+	char s[256];
+
+	assert_chrp_memmem("", "", 0);
+	assert_chrp_memmem("", "a", -1);
+	assert_chrp_memmem("a", "ab", -1);
+	assert_chrp_memmem("abc", "c", 2);
+	assert_chrp_memmem("abc", "bc", 1);
+	assert_chrp_memmem("abcabd", "abd", 3);
+	assert_chrp_memmem("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "aab", 29);
+	assert_chrp_memmem("xyxyxyxyxyxyxyxyxyxyxyxyxyxyxyxyxyxyxyxy", "xyxz", -1);
+	// Occurrences either side of and straddling each 16 byte block.
+	for (int i = 0; i < 60; ++i) {
+		memset(s, '.', 64);
+		s[64] = '\0';
+		memcpy(s+i, "needle", 6);
+		assert_chrp_memmem(s, "needle", i);
+		assert_chrp_memmem(s, "needles", -1);
+	}
+	// Long needle.
+	memset(s, 'a', 200);
+	s[200] = '\0';
+	s[150] = 'b';
+	assert_chrp_memmem(s, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", 150-41);
+}
+
 void test_chrp(void)
 {
 	test_strnchr();
 	test_strnchr_reverse();
 	test_strip_trailchar();
+	test_chrp_memmem();
 }
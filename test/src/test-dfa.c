@@ -0,0 +1,259 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test-dfa.h"
+
+/*
+ * Initialise a scanner with patterns, asserting that they all compile.
+ * @pats: NULL terminated array of patterns
+ */
+static void dfa_init_pats(dfa_t *d, char **pats, int cflags)
+{
+	char errbuf[64];
+
+	dfa_init(d);
+	for (; *pats; ++pats)
+		assert(dfa_add(d, *pats, cflags, errbuf, sizeof(errbuf)));
+}
+
+/*
+ * Assert the pattern matched at an index of a string, and the end of its match.
+ */
+static void assert_dfa_match(dfa_t *d, char *s, int pos, int expected_pat, int expected_end)
+{
+	int end = -1;
+
+	assert(dfa_match(d, s, strlen(s), pos, &end) == expected_pat);
+	if (expected_pat != -1)
+		assert(end == expected_end);
+}
+
+static void assert_dfa_search(dfa_t *d, char *s, int expected_start, int expected_end)
+{
+	int start, end;
+
+	assert((dfa_search(d, s, strlen(s), 0, &start, &end) != -1) == (expected_start != -1));
+	if (expected_start != -1) {
+		assert(start == expected_start);
+		assert(end == expected_end);
+	}
+}
+
+static void test_dfa_literal(void)
+{
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ "abc", NULL }, 0);
+	assert_dfa_match(&d, "abc", 0, 0, 3);
+	assert_dfa_match(&d, "abd", 0, -1, 0);
+	assert_dfa_match(&d, "xabc", 1, 0, 4);
+	assert_dfa_search(&d, "xxabcx", 2, 5);
+	assert_dfa_search(&d, "xxabx", -1, 0);
+	dfa_free(&d);
+
+	dfa_init_pats(&d, (char *[]){ "AbC", NULL }, REG_ICASE);
+	assert_dfa_match(&d, "abc", 0, 0, 3);
+	assert_dfa_match(&d, "ABC", 0, 0, 3);
+	dfa_free(&d);
+}
+
+/*
+ * Test the first pattern matching being chosen, with its longest match.
+ */
+static void test_dfa_priority(void)
+{
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ "if", "[a-z]+", "i", NULL }, 0);
+	assert_dfa_match(&d, "if", 0, 0, 2);
+	assert_dfa_match(&d, "iffy", 0, 0, 2);
+	assert_dfa_match(&d, "ix", 0, 1, 2);
+	assert_dfa_match(&d, "i", 0, 1, 1);
+	dfa_free(&d);
+
+	dfa_init_pats(&d, (char *[]){ "a|ab|abc", NULL }, 0);
+	assert_dfa_match(&d, "abcd", 0, 0, 3);
+	dfa_free(&d);
+}
+
+static void test_dfa_repeat(void)
+{
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ "x(ab)*y", "q+", "r?s", "t{2,3}", "u{2}", "v{1,}w", NULL }, 0);
+	assert_dfa_match(&d, "xy", 0, 0, 2);
+	assert_dfa_match(&d, "xababy", 0, 0, 6);
+	assert_dfa_match(&d, "xabay", 0, -1, 0);
+	assert_dfa_match(&d, "qqq", 0, 1, 3);
+	assert_dfa_match(&d, "s", 0, 2, 1);
+	assert_dfa_match(&d, "rs", 0, 2, 2);
+	assert_dfa_match(&d, "t", 0, -1, 0);
+	assert_dfa_match(&d, "tttt", 0, 3, 3);
+	assert_dfa_match(&d, "uuu", 0, 4, 2);
+	assert_dfa_match(&d, "w", 0, -1, 0);
+	assert_dfa_match(&d, "vvvw", 0, 5, 4);
+	dfa_free(&d);
+}
+
+static void test_dfa_bracket(void)
+{
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ "[]a-c]+", "[^[:alpha:]\\]", "[\\]", NULL }, 0);
+	assert_dfa_match(&d, "]ab]cd", 0, 0, 5);
+	assert_dfa_match(&d, "1", 0, 1, 1);
+	assert_dfa_match(&d, "z", 0, -1, 0);
+	assert_dfa_match(&d, "\\", 0, 2, 1);
+	dfa_free(&d);
+}
+
+static void test_dfa_assert(void)
+{
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ "\\bdo\\b", "^#", "x$", NULL }, 0);
+	assert_dfa_match(&d, "do it", 0, 0, 2);
+	assert_dfa_match(&d, "done", 0, -1, 0);
+	assert_dfa_match(&d, "undo", 2, -1, 0);
+	assert_dfa_match(&d, "a do", 2, 0, 4);
+	assert_dfa_match(&d, "#", 0, 1, 1);
+	assert_dfa_match(&d, " #", 1, -1, 0);
+	assert_dfa_match(&d, "x", 0, 2, 1);
+	assert_dfa_match(&d, "xy", 0, -1, 0);
+	dfa_free(&d);
+}
+
+static void test_dfa_empty(void)
+{
+	dfa_t d;
+
+	// A pattern that can match the empty string doesn't keep later patterns from matching.
+	dfa_init_pats(&d, (char *[]){ "x*", "if", "$", NULL }, 0);
+	assert_dfa_match(&d, "if", 0, 1, 2);
+	assert_dfa_match(&d, "xxif", 0, 0, 2);
+	assert_dfa_match(&d, "ab", 0, 0, 0);
+	assert_dfa_match(&d, "ab", 2, 0, 2);
+	assert_dfa_search(&d, "ab", 0, 0);
+	dfa_free(&d);
+}
+
+static void test_dfa_errors(void)
+{
+	char errbuf[64];
+	dfa_t d;
+
+	dfa_init(&d);
+	assert(!dfa_add(&d, "(ab", 0, errbuf, sizeof(errbuf)));
+	assert(!dfa_add(&d, "ab)", 0, errbuf, sizeof(errbuf)));
+	assert(!dfa_add(&d, "[ab", 0, errbuf, sizeof(errbuf)));
+	assert(!dfa_add(&d, "a\\", 0, errbuf, sizeof(errbuf)));
+	assert(!dfa_add(&d, "a{3,2}", 0, errbuf, sizeof(errbuf)));
+	assert(dfa_add(&d, "ab", 0, errbuf, sizeof(errbuf)));
+	// Patterns that didn't compile never match but keep their index.
+	assert_dfa_match(&d, "ab", 0, 5, 2);
+	dfa_free(&d);
+}
+
+static void test_dfa_alias(void)
+{
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ "a\\s+b", "\\bc", NULL }, 0);
+	dfa_alias(&d, '_', ' ');
+	assert_dfa_match(&d, "a__ b", 0, 0, 5);
+	assert_dfa_match(&d, "_c", 1, 1, 2);
+	dfa_free(&d);
+}
+
+static void test_dfa_disable(void)
+{
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ "ab", "a", "b", NULL }, 0);
+	assert_dfa_match(&d, "ab", 0, 0, 2);
+	dfa_disable(&d, 0);
+	assert_dfa_match(&d, "ab", 0, 1, 1);
+	assert_dfa_match(&d, "ab", 1, 2, 2);
+	dfa_disable(&d, 2);
+	assert_dfa_match(&d, "ab", 1, -1, 0);
+	dfa_free(&d);
+}
+
+/*
+ * Test patterns written to a file being read back into a scanner matching the same.
+ */
+static void test_dfa_write_read(void)
+{
+	FILE *fp = tmpfile();
+	char buf[64];
+	dfa_t d, e;
+
+	dfa_init_pats(&d, (char *[]){ "\\bif\\b", "[a-z]+", NULL }, 0);
+	assert(dfa_write(&d, fp));
+	dfa_free(&d);
+
+	rewind(fp);
+	dfa_init(&e);
+	assert(dfa_read(&e, fp));
+	assert_dfa_match(&e, "if x", 0, 0, 2);
+	assert_dfa_match(&e, "iffy", 0, 1, 4);
+	dfa_free(&e);
+
+	// A truncated file is rejected.
+	rewind(fp);
+	assert(fread(buf, 1, sizeof(buf), fp) > 16);
+	fclose(fp);
+	fp = fmemopen(buf, 16, "rb");
+	dfa_init(&e);
+	assert(!dfa_read(&e, fp));
+	dfa_free(&e);
+	fclose(fp);
+}
+
+/*
+ * Test the scanner staying correct after its states are thrown away for having too many,
+ * checking its matches against regexec().
+ */
+static void test_dfa_flush(void)
+{
+	// Telling whether there's an 'a' 11 characters before the end takes 2^12 states.
+	char *pat = "[ab]*a[ab]{11}";
+	char s[256];
+	regmatch_t m;
+	regex_t re;
+	int end, n;
+	dfa_t d;
+
+	dfa_init_pats(&d, (char *[]){ pat, NULL }, 0);
+	assert(regcomp(&re, pat, REG_EXTENDED) == 0);
+	srand(1);
+	for (int i = 0; i < 64; ++i) {
+		n = 1+rand()%(sizeof(s)-1);
+		for (int j = 0; j < n; ++j)
+			s[j] = rand()%2 ? 'a' : 'b';
+		s[n] = '\0';
+		if (regexec(&re, s, 1, &m, 0) == 0) {
+			assert(dfa_match(&d, s, n, 0, &end) == 0);
+			assert(end == m.rm_eo);
+		} else {
+			assert(dfa_match(&d, s, n, 0, &end) == -1);
+		}
+		assert(d.states.len <= DFA_MAX_STATES+n+1);
+	}
+	regfree(&re);
+	dfa_free(&d);
+}
+
+void test_dfa(void)
+{
+	test_dfa_literal();
+	test_dfa_priority();
+	test_dfa_repeat();
+	test_dfa_bracket();
+	test_dfa_assert();
+	test_dfa_empty();
+	test_dfa_errors();
+	test_dfa_alias();
+	test_dfa_disable();
+	test_dfa_write_read();
+	test_dfa_flush();
+}
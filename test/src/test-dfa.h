@@ -0,0 +1,9 @@
+#ifndef TEST_DFA_H
+#define TEST_DFA_H
+
+#include <assert.h>
+#include "../../src/synhl/dfa.h"
+
+void test_dfa(void);
+
+#endif
@@ -166,6 +166,64 @@ static void test_dlist_insert_delete(void)
 	dlist_free(&d, NULL);
 }
 
+static void test_dlist_insert_array(void)
+{
+	dlist_t d;
+
+	dlist_init_int_array(&d, (int[]){ 1, 2, 3 }, 3);
+	dlist_insert_array(&d, 1, (int[]){ 7, 8 }, 2);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 7, 8, 2, 3 }, 5);
+	dlist_insert_array(&d, d.len, (int[]){ 9 }, 1);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 7, 8, 2, 3, 9 }, 6);
+
+	// Grow past the minimum capacity in one insert.
+	dlist_insert_array(&d, 0, (int[]){ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, 11);
+	assert(d.len == 17);
+	assert(d.capacity == 2*DLIST_MIN_CAP);
+	dlist_free(&d, NULL);
+}
+
+static void test_dlist_delete_range(void)
+{
+	dlist_t d;
+
+	dlist_init_int_array(&d, (int[]){ 1, 2, 3, 4, 5 }, 5);
+	dlist_delete_range(&d, 1, 3, NULL);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 5 }, 2);
+	dlist_delete_range(&d, 0, 2, NULL);
+	assert(d.len == 0);
+	dlist_free(&d, NULL);
+}
+
+static void test_dlist_splice_out(void)
+{
+	dlist_t d, out;
+
+	dlist_init_int_array(&d, (int[]){ 1, 2, 3, 4, 5 }, 5);
+	dlist_init_int_array(&out, (int[]){ 9 }, 1);
+	dlist_splice_out(&d, 3, 2, &out);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 2, 3 }, 3);
+	assert_dlist_eq_int_array(&out, (int[]){ 9, 4, 5 }, 3);
+	dlist_free(&d, NULL);
+	dlist_free(&out, NULL);
+}
+
+static void test_dlist_splice_zeroed(void)
+{
+	dlist_t d;
+
+	dlist_init_int_array(&d, (int[]){ 1, 2, 3, 4, 5 }, 5);
+	dlist_splice_zeroed(&d, 1, 2, 4);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 2, 3, 0, 0, 4, 5 }, 7);
+	dlist_splice_zeroed(&d, 2, 4, 1);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 2, 3, 5 }, 4);
+	dlist_splice_zeroed(&d, 4, 0, 2);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 2, 3, 5, 0, 0 }, 6);
+	dlist_splice_zeroed(&d, 0, 3, 3);
+	assert_dlist_eq_int_array(&d, (int[]){ 1, 2, 3, 5, 0, 0 }, 6);
+	dlist_free(&d, NULL);
+}
+
 static void test_dlist_delete_elem(void)
 {
 	dlist_t d;
@@ -277,6 +335,10 @@ static void test_dlist(void)
 	test_dlist_set();
 	test_dlist_insert_delete();
 	test_dlist_delete_elem();
+	test_dlist_insert_array();
+	test_dlist_delete_range();
+	test_dlist_splice_out();
+	test_dlist_splice_zeroed();
 	test_dlist_split();
 	test_dlist_cat();
 	test_dlist_copy();
@@ -284,8 +346,83 @@ static void test_dlist(void)
 	test_dlist_copy_array();
 }
 
+static void test_hmap_put_get(void)
+{
+	hmap_t h;
+	int v;
+
+	hmap_init(&h, 0, sizeof(int));
+	assert(!hmap_get(&h, 1));
+	v = 10;
+	assert(*(int *)hmap_put(&h, 1, &v) == 10);
+	v = 20;
+	hmap_put(&h, 2, &v);
+	assert(*(int *)hmap_get(&h, 1) == 10);
+	assert(*(int *)hmap_get(&h, 2) == 20);
+	// Overwriting a key doesn't add another.
+	v = 30;
+	hmap_put(&h, 1, &v);
+	assert(*(int *)hmap_get(&h, 1) == 30);
+	assert(h.len == 2);
+
+	hmap_free(&h, NULL);
+}
+
+static void test_hmap_grow(void)
+{
+	hmap_t h;
+
+	hmap_init(&h, 0, sizeof(int));
+	for (int i = 1; i <= 1000; ++i)
+		hmap_put(&h, i*7, &i);
+	assert(h.len == 1000);
+	assert(h.capacity >= 1000);
+	for (int i = 1; i <= 1000; ++i)
+		assert(*(int *)hmap_get(&h, i*7) == i);
+	assert(!hmap_get(&h, 3));
+
+	hmap_free(&h, NULL);
+}
+
+static void test_hmap_delete(void)
+{
+	hmap_t h;
+
+	hmap_init(&h, 0, sizeof(int));
+	for (int i = 1; i <= 1000; ++i)
+		hmap_put(&h, i, &i);
+	for (int i = 1; i <= 1000; i += 2)
+		assert(hmap_delete(&h, i, NULL));
+	assert(!hmap_delete(&h, 1, NULL));
+	assert(h.len == 500);
+	// Keys after deleted keys must still be found.
+	for (int i = 1; i <= 1000; ++i) {
+		if (i % 2)
+			assert(!hmap_get(&h, i));
+		else
+			assert(*(int *)hmap_get(&h, i) == i);
+	}
+
+	hmap_clear(&h, NULL);
+	assert(h.len == 0);
+	assert(!hmap_get(&h, 2));
+
+	hmap_free(&h, NULL);
+}
+
+/*
+ * Test the hash map data structure.
+ */
+static void test_hmap(void)
+{
+	test_hmap_put_get();
+	test_hmap_grow();
+	test_hmap_delete();
+}
+
 void test_ds(void)
 {
 	test_dlist();
+	test_hmap();
 }
 
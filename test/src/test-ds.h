@@ -3,6 +3,7 @@
 
 #include <assert.h>
 #include "../../src/ds/dlist.h"
+#include "../../src/ds/hmap.h"
 
 void test_ds(void);
 
@@ -0,0 +1,69 @@
+#include "test-epoch.h"
+
+static int nfreed;
+
+static void count_free(void *p)
+{
+	++nfreed;
+}
+
+static void test_epoch_no_reader(void)
+{
+	int a, b;
+	epoch_t e;
+
+	epoch_init(&e);
+	assert(!epoch_reclaim(&e));
+	epoch_retire(&e, &a);
+	epoch_retire(&e, &b);
+	assert(epoch_reclaim(&e) == &a);
+	assert(epoch_reclaim(&e) == &b);
+	assert(!epoch_reclaim(&e));
+	epoch_free(&e, count_free);
+}
+
+static void test_epoch_reader(void)
+{
+	int a, b, c;
+	epoch_t e;
+
+	epoch_init(&e);
+	// Retired while the reader could be reading it, so kept until the reader leaves.
+	epoch_enter(&e);
+	epoch_retire(&e, &a);
+	assert(!epoch_reclaim(&e));
+	epoch_leave(&e);
+	assert(epoch_reclaim(&e) == &a);
+
+	// Retired before the reader entered, so it can only be reading what replaced it.
+	epoch_retire(&e, &b);
+	epoch_enter(&e);
+	epoch_retire(&e, &c);
+	assert(epoch_reclaim(&e) == &b);
+	assert(!epoch_reclaim(&e));
+	epoch_leave(&e);
+	assert(epoch_reclaim(&e) == &c);
+	epoch_free(&e, count_free);
+}
+
+static void test_epoch_free(void)
+{
+	int a, b;
+	epoch_t e;
+
+	epoch_init(&e);
+	epoch_enter(&e);
+	epoch_retire(&e, &a);
+	epoch_retire(&e, &b);
+	epoch_leave(&e);
+	nfreed = 0;
+	epoch_free(&e, count_free);
+	assert(nfreed == 2);
+}
+
+void test_epoch(void)
+{
+	test_epoch_no_reader();
+	test_epoch_reader();
+	test_epoch_free();
+}
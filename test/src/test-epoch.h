@@ -0,0 +1,9 @@
+#ifndef TEST_EPOCH_H
+#define TEST_EPOCH_H
+
+#include <assert.h>
+#include "../../src/epoch.h"
+
+void test_epoch(void);
+
+#endif
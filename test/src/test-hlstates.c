@@ -0,0 +1,188 @@
+#include <string.h>
+#include "test-hlstates.h"
+
+#define MAX_ROWS 128
+
+/*
+ * Lines as the regions they open and close: '(' opens one, ')' closes it and any other
+ * character leaves the state as it is. A '?' line isn't highlighted yet.
+ */
+typedef struct test_lines {
+	char kinds[MAX_ROWS+1];
+	int calls;  // Number of times the state a line ends in was got.
+} test_lines_t;
+
+static bool end_state(int row, int start_state, test_lines_t *tl, int *out_state)
+{
+	++tl->calls;
+	if (tl->kinds[row] == '?')
+		return false;
+	*out_state = tl->kinds[row] == '(' ? 1 : tl->kinds[row] == ')' ? 0 : start_state;
+	return true;
+}
+
+/*
+ * Replace rows of the lines, and the states along with them.
+ */
+static void splice(hlstates_t *s, test_lines_t *tl, int row, int nold, char *new)
+{
+	int nnew = strlen(new);
+
+	memmove(tl->kinds+row+nnew, tl->kinds+row+nold, strlen(tl->kinds+row+nold)+1);
+	memcpy(tl->kinds+row, new, nnew);
+	hlstates_splice(s, row, nold, nnew);
+}
+
+/*
+ * Assert that the state every line starts in is found as it would be from scratch.
+ */
+static void assert_states(hlstates_t *s, test_lines_t *tl)
+{
+	int n = strlen(tl->kinds), state, expected = 0;
+
+	assert(hlstates_find(s, n-1, (hlstates_end_fn)end_state, tl, &state));
+	for (int row = 0; row < n; ++row) {
+		assert(hlstates_find(s, row, (hlstates_end_fn)end_state, tl, &state));
+		assert(state == expected);
+		end_state(row, expected, tl, &expected);
+	}
+}
+
+static void test_hlstates_find(void)
+{
+	test_lines_t tl = { .kinds = "a(b)c(d" };
+	hlstates_t s;
+	int state;
+
+	hlstates_init(&s);
+	assert(hlstates_find(&s, 0, (hlstates_end_fn)end_state, &tl, &state) && state == 0);
+	assert(tl.calls == 0);
+	assert(hlstates_find(&s, 6, (hlstates_end_fn)end_state, &tl, &state) && state == 1);
+	assert(tl.calls == 6 && s.known == 7);
+	// Found states are kept.
+	tl.calls = 0;
+	assert(hlstates_find(&s, 3, (hlstates_end_fn)end_state, &tl, &state) && state == 1);
+	assert(tl.calls == 0);
+	assert_states(&s, &tl);
+
+	// Stops at the first line not highlighted, which is the last known one.
+	hlstates_reset(&s);
+	strcpy(tl.kinds, "a(?)c");
+	assert(!hlstates_find(&s, 4, (hlstates_end_fn)end_state, &tl, &state));
+	assert(s.known-1 == 2);
+	hlstates_free(&s);
+}
+
+static void test_hlstates_edit_known(void)
+{
+	test_lines_t tl = { .kinds = "a(bcd)efgh" };
+	hlstates_t s;
+
+	hlstates_init(&s);
+	assert_states(&s, &tl);
+	// Opening a region before the rows known carries its state on to every row after.
+	splice(&s, &tl, 3, 1, "(");
+	assert(s.known == 3 && s.dirty_end == 4);
+	strcpy(tl.kinds, "abc(de)fgh");
+	hlstates_splice(&s, 0, 10, 10);
+	assert(s.known == 0);
+	assert_states(&s, &tl);
+	// Rows inserted and deleted before the rows known.
+	splice(&s, &tl, 1, 0, "((");
+	assert(s.known == 1 && s.dirty_end == 3);
+	assert_states(&s, &tl);
+	splice(&s, &tl, 2, 3, "");
+	assert(s.known == 2 && s.dirty_end == 2);
+	assert_states(&s, &tl);
+	hlstates_free(&s);
+}
+
+static void test_hlstates_edit_dirty(void)
+{
+	test_lines_t tl = { .kinds = "abcdefghij" };
+	hlstates_t s;
+
+	hlstates_init(&s);
+	assert_states(&s, &tl);
+	splice(&s, &tl, 2, 0, "(x");
+	assert(s.known == 2 && s.dirty_end == 4);
+	// Replaced within the rows changed, they stay the rows changed.
+	splice(&s, &tl, 3, 1, "y");
+	assert(s.known == 2 && s.dirty_end == 4);
+	// Inserted within them, the unchanged rows after them move down.
+	splice(&s, &tl, 3, 0, "zz");
+	assert(s.known == 2 && s.dirty_end == 6);
+	// Deleted across their end, the rows replacing them are changed too.
+	splice(&s, &tl, 5, 3, ")");
+	assert(s.known == 2 && s.dirty_end == 6);
+	assert_states(&s, &tl);
+	hlstates_free(&s);
+}
+
+static void test_hlstates_edit_unfound(void)
+{
+	test_lines_t tl = { .kinds = "a(bc)defgh" };
+	hlstates_t s;
+	int state;
+
+	hlstates_init(&s);
+	assert(hlstates_find(&s, 3, (hlstates_end_fn)end_state, &tl, &state) && state == 1);
+	assert(s.states.len == 4);
+	// Edits wholly after the states found leave them be.
+	splice(&s, &tl, 6, 2, "(");
+	assert(s.known == 4 && s.states.len == 4);
+	// Deleting rows past the states found drops the states after the edit.
+	splice(&s, &tl, 2, 4, "");
+	assert(s.known == 2 && s.dirty_end == 2 && s.states.len == 2);
+	assert_states(&s, &tl);
+	hlstates_free(&s);
+}
+
+static void test_hlstates_skip(void)
+{
+	test_lines_t tl;
+	hlstates_t s;
+	int state;
+
+	memset(tl.kinds, 'a', MAX_ROWS);
+	tl.kinds[MAX_ROWS] = '\0';
+	tl.kinds[10] = '(';
+	tl.kinds[20] = ')';
+	hlstates_init(&s);
+	assert_states(&s, &tl);
+
+	// An edit that leaves the state of the row after it unchanged has only the states of the
+	// row edited and the one after it found again, the rest still hold.
+	tl.calls = 0;
+	splice(&s, &tl, 50, 1, "b");
+	assert(hlstates_find(&s, MAX_ROWS-1, (hlstates_end_fn)end_state, &tl, &state));
+	assert(tl.calls == 2 && s.known == MAX_ROWS);
+	assert_states(&s, &tl);
+	// Inside a region, the same.
+	tl.calls = 0;
+	splice(&s, &tl, 15, 1, "b");
+	assert(hlstates_find(&s, MAX_ROWS-1, (hlstates_end_fn)end_state, &tl, &state));
+	assert(tl.calls == 2);
+	// One that changes it finds them again until they start in the same state as before.
+	tl.calls = 0;
+	splice(&s, &tl, 5, 1, "(");
+	assert(hlstates_find(&s, MAX_ROWS-1, (hlstates_end_fn)end_state, &tl, &state));
+	assert(tl.calls == 7);
+	assert_states(&s, &tl);
+	// The rows changed are found again even if they start in the same state as before.
+	tl.calls = 0;
+	splice(&s, &tl, 30, 3, "a()");
+	assert(hlstates_find(&s, MAX_ROWS-1, (hlstates_end_fn)end_state, &tl, &state));
+	assert(tl.calls == 4);
+	assert_states(&s, &tl);
+	hlstates_free(&s);
+}
+
+void test_hlstates(void)
+{
+	test_hlstates_find();
+	test_hlstates_edit_known();
+	test_hlstates_edit_dirty();
+	test_hlstates_edit_unfound();
+	test_hlstates_skip();
+}
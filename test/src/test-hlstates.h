@@ -0,0 +1,9 @@
+#ifndef TEST_HLSTATES_H
+#define TEST_HLSTATES_H
+
+#include <assert.h>
+#include "../../src/synhl/hlstates.h"
+
+void test_hlstates(void);
+
+#endif
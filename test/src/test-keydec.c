@@ -0,0 +1,102 @@
+#include <string.h>
+#include "test-keydec.h"
+#include "../../src/getch.h"
+
+/*
+ * Assert that decoding bytes gives keys, with no bytes left over.
+ * @keys: keys expected, terminated by ERR
+ */
+static void assert_keydec(char *bytes, int *keys)
+{
+	keydec_t k;
+
+	keydec_init(&k);
+	keydec_feed(&k, bytes, strlen(bytes));
+	for (; *keys != ERR; ++keys)
+		assert(keydec_next(&k, false) == *keys);
+	assert(keydec_next(&k, false) == ERR);
+	assert(!keydec_pending(&k));
+	keydec_free(&k);
+}
+
+static void test_keydec_plain(void)
+{
+	assert_keydec("ab\n\r", (int[]){ 'a', 'b', '\n', ASCII_ENTER, ERR });
+	assert_keydec("\x7f\xc3\xa9", (int[]){ ASCII_BS, 0xc3, 0xa9, ERR });
+}
+
+static void test_keydec_seqs(void)
+{
+	assert_keydec("\33[A\33OB\33[C\33[D", (int[]){ KEY_UP, KEY_DOWN, KEY_RIGHT, KEY_LEFT, ERR });
+	assert_keydec("\33[1~\33[4~\33[H\33OF", (int[]){ KEY_HOME, KEY_END, KEY_HOME, KEY_END, ERR });
+	assert_keydec("\33[3~\33[5~\33[6~", (int[]){ KEY_DC, KEY_PPAGE, KEY_NPAGE, ERR });
+	assert_keydec("\33OR\33[15~\33[24~", (int[]){ KEY_F(3), KEY_F(5), KEY_F(12), ERR });
+}
+
+static void test_keydec_modifiers(void)
+{
+	assert_keydec("\33[1;2D\33[1;2A\33[3;2~", (int[]){ KEY_SLEFT, KEY_SR, KEY_SDC, ERR });
+	assert_keydec("\33[1;2R\33O2R\33[15;5~", (int[]){ KEY_F(15), KEY_F(15), KEY_F(29), ERR });
+	// Modifiers curses has no key for are dropped.
+	assert_keydec("\33[1;5C", (int[]){ KEY_RIGHT, ERR });
+}
+
+static void test_keydec_unknown(void)
+{
+	// Unknown sequences are dropped, and invalid ones decoded as an escape then characters.
+	assert_keydec("\33[99~a\33[?1;2cb", (int[]){ 'a', 'b', ERR });
+	assert_keydec("\33[1\n", (int[]){ ASCII_ESC, '[', '1', '\n', ERR });
+	// Alt with a key.
+	assert_keydec("\33x", (int[]){ ASCII_ESC, 'x', ERR });
+}
+
+static void test_keydec_timeout(void)
+{
+	keydec_t k;
+
+	keydec_init(&k);
+	keydec_feed(&k, "\33", 1);
+	assert(keydec_next(&k, false) == ERR);
+	assert(keydec_pending(&k));
+	assert(keydec_next(&k, true) == ASCII_ESC);
+
+	// The rest of a sequence read later.
+	keydec_feed(&k, "\33[1", 3);
+	assert(keydec_next(&k, false) == ERR);
+	keydec_feed(&k, ";2B", 3);
+	assert(keydec_next(&k, false) == KEY_SF);
+
+	// The start of a sequence that never finishes.
+	keydec_feed(&k, "\33[", 2);
+	assert(keydec_next(&k, true) == ASCII_ESC);
+	assert(keydec_next(&k, true) == '[');
+	assert(!keydec_pending(&k));
+	keydec_free(&k);
+}
+
+static void test_keydec_paste(void)
+{
+	keydec_t k;
+
+	assert_keydec("\33[200~a\33[Ab\33[201~\33[A",
+		      (int[]){ 'a', '[', 'A', 'b', KEY_UP, ERR });
+
+	// The end of a paste split across reads.
+	keydec_init(&k);
+	keydec_feed(&k, "\33[200~x\33[20", 11);
+	assert(keydec_next(&k, false) == 'x');
+	assert(keydec_next(&k, false) == ERR);
+	keydec_feed(&k, "1~\33OA", 5);
+	assert(keydec_next(&k, false) == KEY_UP);
+	keydec_free(&k);
+}
+
+void test_keydec(void)
+{
+	test_keydec_plain();
+	test_keydec_seqs();
+	test_keydec_modifiers();
+	test_keydec_unknown();
+	test_keydec_timeout();
+	test_keydec_paste();
+}
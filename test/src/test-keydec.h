@@ -0,0 +1,9 @@
+#ifndef TEST_KEYDEC_H
+#define TEST_KEYDEC_H
+
+#include <assert.h>
+#include "../../src/keydec.h"
+
+void test_keydec(void);
+
+#endif
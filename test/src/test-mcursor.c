@@ -0,0 +1,92 @@
+#include <string.h>
+#include "test-mcursor.h"
+
+#define TEST_TABSZ 4
+
+/*
+ * Assert that an edit at cursors on a line gives an expected line and cursor columns.
+ * Tabs in the expected line are written as '\t' for the tab start and '-' for its continuation.
+ * @cols: columns of the cursors, ascending, terminated by -1
+ * @expected_cols: columns of the cursors after the edit
+ */
+static void assert_edit_line(char *s, int *cols, enum mcursor_op op, char c, char *expected,
+			     int *expected_cols)
+{
+	cursor_t crss[8], *crsps[8];
+	char exp[64];
+	int n = 0, len = strlen(expected);
+	line_t l;
+
+	for (int i = 0; i < len; ++i)
+		exp[i] = expected[i] == '\t' ? TAB_START : expected[i] == '-' ? TAB_CONT : expected[i];
+	for (; cols[n] != -1; ++n) {
+		crss[n] = (cursor_t){ .row = 0, .col = cols[n] };
+		crsps[n] = &crss[n];
+	}
+	line_init(&l, s, strlen(s), TEST_TABSZ);
+	mcursor_edit_line(&l, crsps, n, op, c, TEST_TABSZ);
+
+	assert(l.len == len && !memcmp(l.array, exp, len));
+	for (int i = 0; i < n; ++i)
+		assert(crss[i].col == expected_cols[i]);
+	line_free(&l);
+}
+
+static void test_mcursor_insert(void)
+{
+	// Before, in the middle of and at the end of the line.
+	assert_edit_line("abcd\n", (int[]){ 0, 2, 4, -1 }, MCURSOR_INSERT, 'x', "xabxcdx\n",
+			 (int[]){ 1, 4, 7 });
+	// Inserting before a tab realigns it.
+	assert_edit_line("a\tb", (int[]){ 0, -1 }, MCURSOR_INSERT, 'x', "xa\t-b", (int[]){ 1 });
+	assert_edit_line("ab", (int[]){ 1, -1 }, MCURSOR_INSERT, '\t', "a\t--b", (int[]){ 4 });
+}
+
+static void test_mcursor_delete(void)
+{
+	assert_edit_line("abcd\n", (int[]){ 0, 2, -1 }, MCURSOR_DELETE, 0, "bd\n",
+			 (int[]){ 0, 1 });
+	// The newline isn't deleted, and a tab is deleted whole.
+	assert_edit_line("a\tb\n", (int[]){ 1, 5, -1 }, MCURSOR_DELETE, 0, "ab\n",
+			 (int[]){ 1, 2 });
+}
+
+static void test_mcursor_backspace(void)
+{
+	// Nothing is deleted before the start of the line.
+	assert_edit_line("abcd", (int[]){ 0, 2, -1 }, MCURSOR_BACKSPACE, 0, "acd",
+			 (int[]){ 0, 1 });
+	assert_edit_line("a\tb", (int[]){ 4, -1 }, MCURSOR_BACKSPACE, 0, "ab", (int[]){ 1 });
+}
+
+static void test_mcursor_normalise(void)
+{
+	cursor_t primary = { .row = 1, .col = 2 };
+	cursor_t cs[] = { { 2, 0 }, { 1, 2 }, { 0, 5 }, { 2, 0 }, { 1, 3 } };
+	cursor_t expected[] = { { 0, 5 }, { 1, 3 }, { 2, 0 } };
+	cursor_t *c;
+	dlist_t extras;
+
+	dlist_init(&extras, DLIST_MIN_CAP, sizeof(cursor_t));
+	for (int i = 0; i < 5; ++i)
+		dlist_append(&extras, &cs[i]);
+	mcursor_normalise(&primary, &extras);
+
+	assert(extras.len == 3);
+	for (int i = 0; i < 3; ++i) {
+		c = dlist_get_address(&extras, i);
+		assert(c->row == expected[i].row && c->col == expected[i].col);
+	}
+	assert(mcursor_exists(&primary, &extras, 1, 2));
+	assert(mcursor_exists(&primary, &extras, 2, 0));
+	assert(!mcursor_exists(&primary, &extras, 2, 1));
+	dlist_free(&extras, NULL);
+}
+
+void test_mcursor(void)
+{
+	test_mcursor_insert();
+	test_mcursor_delete();
+	test_mcursor_backspace();
+	test_mcursor_normalise();
+}
@@ -0,0 +1,9 @@
+#ifndef TEST_MCURSOR_H
+#define TEST_MCURSOR_H
+
+#include <assert.h>
+#include "../../src/mcursor.h"
+
+void test_mcursor(void);
+
+#endif
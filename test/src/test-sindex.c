@@ -0,0 +1,169 @@
+#include <string.h>
+#include "test-sindex.h"
+
+#define TEST_TABSZ 4
+
+static void line_init_str(line_t *l, char *s)
+{
+	line_init(l, s, strlen(s), TEST_TABSZ);
+}
+
+static bool sig_eq(tsig_t *a, tsig_t *b)
+{
+	return a->bits[0] == b->bits[0] && a->bits[1] == b->bits[1];
+}
+
+/*
+ * Get whether a line could contain a string, as a search with an index of it would.
+ */
+static bool line_may_contain(char *line, char *s)
+{
+	tsig_t line_sig, sig;
+	line_t l;
+	bool may;
+
+	line_init_str(&l, line);
+	tsig_of(l.array, line_len(&l), &line_sig);
+	tsig_of_regex(s, &sig);
+	may = (line_sig.bits[0] & sig.bits[0]) == sig.bits[0] &&
+	      (line_sig.bits[1] & sig.bits[1]) == sig.bits[1];
+	line_free(&l);
+	return may;
+}
+
+static void test_tsig_of(void)
+{
+	tsig_t sig;
+
+	tsig_of("ab", 2, &sig);
+	assert(tsig_empty(&sig));
+	tsig_of("abc", 3, &sig);
+	assert(!tsig_empty(&sig));
+
+	// Strings spanning several trigrams, at the start, middle and end of the line.
+	assert(line_may_contain("int main(void)\n", "int m"));
+	assert(line_may_contain("int main(void)\n", "main\\("));
+	assert(line_may_contain("int main(void)\n", "void\\)"));
+	assert(!line_may_contain("int main(void)\n", "mian"));
+	// A tab is a single character to a string crossing it, however many columns it takes.
+	assert(line_may_contain("a\tbcd\n", "a\tb"));
+	assert(line_may_contain("a\tbcd\n", "a\tbcd"));
+	assert(line_may_contain("abc\tdef\n", "c\td"));
+	assert(!line_may_contain("a\tbcd\n", "a  b"));
+	assert(!line_may_contain("a    bcd\n", "a\tb"));
+}
+
+static void assert_regex_sig(char *pat, char *expected_lit)
+{
+	tsig_t sig, expected;
+
+	tsig_of_regex(pat, &sig);
+	tsig_of(expected_lit, strlen(expected_lit), &expected);
+	assert(sig_eq(&sig, &expected));
+}
+
+static void test_tsig_of_regex(void)
+{
+	// No string every match contains.
+	assert_regex_sig("", "");
+	assert_regex_sig("abc|def", "");
+	assert_regex_sig("(abc)", "");
+	assert_regex_sig("[abc]d.e", "");
+	assert_regex_sig("\\w+\\s*", "");
+	assert_regex_sig("ab*c?d{2}", "");
+	// The longest run of literal characters outside any group, the first if tied.
+	assert_regex_sig("foo.*bar", "foo");
+	assert_regex_sig("ab?cde", "cde");
+	assert_regex_sig("(x|y)abcd", "abcd");
+	assert_regex_sig("[]bc]defg", "defg");
+	assert_regex_sig("ab+cd", "ab");
+	assert_regex_sig("a\\.bcd", "a.bcd");
+	assert_regex_sig("^main\\($", "main(");
+}
+
+static void lines_init_strs(lines_t *ls, char **strs, int n)
+{
+	line_t l;
+
+	dlist_init(ls, n, sizeof(line_t));
+	for (int i = 0; i < n; ++i) {
+		line_init_str(&l, strs[i]);
+		dlist_append(ls, &l);
+	}
+}
+
+/*
+ * Assert that an index has the same signatures as one built from scratch of the lines.
+ */
+static void assert_index_of(sindex_t *si, lines_t *ls)
+{
+	sindex_t *built = sindex_alloc();
+
+	sindex_build(built, ls);
+	assert(si->sigs.len == ls->len);
+	for (int i = 0; i < ls->len; ++i)
+		assert(sig_eq(dlist_get_address(&si->sigs, i), dlist_get_address(&built->sigs, i)));
+	sindex_free(built);
+}
+
+static bool index_may_match(sindex_t *si, int row, char *s)
+{
+	tsig_t sig;
+
+	tsig_of(s, strlen(s), &sig);
+	return sindex_may_match(si, row, &sig);
+}
+
+static void test_sindex_splice(void)
+{
+	sindex_t *si = sindex_alloc();
+	lines_t ls;
+	line_t l;
+
+	lines_init_strs(&ls, (char *[]){ "alpha\n", "beta\n", "gamma\n", "delta\n" }, 4);
+	sindex_build(si, &ls);
+	assert_index_of(si, &ls);
+	assert(index_may_match(si, 2, "gamma"));
+	assert(!index_may_match(si, 1, "gamma"));
+
+	// Spliced in.
+	line_init_str(&l, "epsilon\n");
+	dlist_insert(&ls, 1, &l);
+	line_init_str(&l, "zeta\n");
+	dlist_insert(&ls, 2, &l);
+	sindex_splice(si, &ls, 1, 0, 2);
+	assert_index_of(si, &ls);
+	assert(index_may_match(si, 1, "epsilon") && index_may_match(si, 5, "delta"));
+
+	// Spliced out, the last rows included.
+	dlist_delete_range(&ls, 4, 2, (dlist_elem_fn)line_free);
+	sindex_splice(si, &ls, 4, 2, 0);
+	dlist_delete_ind(&ls, 0, (dlist_elem_fn)line_free);
+	sindex_splice(si, &ls, 0, 1, 0);
+	assert_index_of(si, &ls);
+	assert(index_may_match(si, 0, "epsilon") && !index_may_match(si, 0, "alpha"));
+
+	// Replaced in place, and more rows replacing fewer.
+	line_free(dlist_get_address(&ls, 1));
+	line_init_str(dlist_get_address(&ls, 1), "eta\tthe\n");
+	sindex_splice(si, &ls, 1, 1, 1);
+	assert_index_of(si, &ls);
+	dlist_delete_ind(&ls, 2, (dlist_elem_fn)line_free);
+	line_init_str(&l, "theta\n");
+	dlist_insert(&ls, 2, &l);
+	line_init_str(&l, "iota\n");
+	dlist_insert(&ls, 3, &l);
+	sindex_splice(si, &ls, 2, 1, 2);
+	assert_index_of(si, &ls);
+	assert(!index_may_match(si, 2, "beta") && index_may_match(si, 3, "iota"));
+
+	sindex_free(si);
+	dlist_free(&ls, (dlist_elem_fn)line_free);
+}
+
+void test_sindex(void)
+{
+	test_tsig_of();
+	test_tsig_of_regex();
+	test_sindex_splice();
+}
@@ -0,0 +1,9 @@
+#ifndef TEST_SINDEX_H
+#define TEST_SINDEX_H
+
+#include <assert.h>
+#include "../../src/sindex.h"
+
+void test_sindex(void);
+
+#endif
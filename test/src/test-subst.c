@@ -0,0 +1,52 @@
+#include <string.h>
+#include "test-subst.h"
+
+#define TEST_TABSZ 4
+
+/*
+ * Assert that substituting in a line gives an expected line and number of matches replaced.
+ * @cmd: substitution as given to the sub command, such as "/pattern/replacement/g"
+ */
+static void assert_subst(char *s, char *cmd, char *expected, int expected_nsubs)
+{
+	char buf[128], *rest;
+	lines_t ls;
+	line_t l;
+	subst_t sub;
+
+	strcpy(buf, cmd);
+	assert(subst_parse(buf, &sub, &rest));
+	dlist_init(&ls, DLIST_MIN_CAP, sizeof(line_t));
+	line_init(&l, s, strlen(s), TEST_TABSZ);
+	dlist_append(&ls, &l);
+
+	assert(subst_lines(&sub, &ls, 0, 0, TEST_TABSZ, NULL, 0) == expected_nsubs);
+	l = *(line_t *)dlist_get_address(&ls, 0);
+	assert(l.len == strlen(expected) && !memcmp(l.array, expected, l.len));
+	dlist_free(&ls, (dlist_elem_fn)line_free);
+}
+
+static void test_subst_global(void)
+{
+	assert_subst("abcabc\n", "/b/x/", "axcabc\n", 1);
+	assert_subst("abcabc\n", "/b/x/g", "axcaxc\n", 2);
+	assert_subst("abc\n", "/(b)(c)/\\2\\1&/", "acbbc\n", 1);
+	assert_subst("abc", "/x/y/g", "abc", 0);
+	// Empty matches between every character.
+	assert_subst("abc", "/x*/-/g", "-a-b-c-", 4);
+}
+
+static void test_subst_anchors(void)
+{
+	// Matches after the first still see the characters before them.
+	assert_subst("aaa", "/\\<a/X/g", "Xaa", 1);
+	assert_subst("aaa", "/^a/X/g", "Xaa", 1);
+	assert_subst("ab ab", "/\\<a/X/g", "Xb Xb", 2);
+	assert_subst("aaa", "/a$/X/g", "aaX", 1);
+}
+
+void test_subst(void)
+{
+	test_subst_global();
+	test_subst_anchors();
+}
@@ -0,0 +1,9 @@
+#ifndef TEST_SUBST_H
+#define TEST_SUBST_H
+
+#include <assert.h>
+#include "../../src/subst.h"
+
+void test_subst(void);
+
+#endif
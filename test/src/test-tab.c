@@ -1,3 +1,4 @@
+#include <string.h>
 #include "test-tab.h"
 
 #define TEST_TABSZ 4
@@ -23,8 +24,42 @@ void test_tab_dist(void)
 	assert_tab_dist(121, 3);
 }
 
+/*
+ * Assert that copying a string to a column realigns its tabs into an expected string.
+ * Tabs in the strings are written as '\t' for the tab start and '-' for its continuation.
+ */
+void assert_tab_realigned_copy(char *s, int col, char *expected)
+{
+	char src[64], dest[64];
+	int n = strlen(s);
+	int end;
+
+	for (int i = 0; i <= n; ++i)
+		src[i] = s[i] == '\t' ? TAB_START : s[i] == '-' ? TAB_CONT : s[i];
+	memset(dest, 'x', sizeof(dest));
+	end = tab_realigned_copy(dest, col, src, n, TEST_TABSZ);
+
+	assert(end == tab_realigned_col(src, n, col, TEST_TABSZ));
+	assert(end == strlen(expected));
+	for (int i = 0; i < end; ++i)
+		assert(dest[i] == (expected[i] == '\t' ? TAB_START : expected[i] == '-' ? TAB_CONT : expected[i]));
+}
+
+void test_tab_realign(void)
+{
+	assert_tab_realigned_copy("ab", 0, "ab");
+	assert_tab_realigned_copy("ab", 2, "xxab");
+	// Tab shrinks to fill up to the next tabstop.
+	assert_tab_realigned_copy("\t---a", 1, "x\t--a");
+	assert_tab_realigned_copy("\t---a", 3, "xxx\ta");
+	// Tab grows to fill up to the next tabstop.
+	assert_tab_realigned_copy("\ta", 0, "\t---a");
+	assert_tab_realigned_copy("a\t-\t---", 2, "xxa\t\t---");
+}
+
 void test_tab(void)
 {
 	test_tab_dist();
+	test_tab_realign();
 }
 